@@ -59,7 +59,11 @@
 #define configUSE_RECURSIVE_MUTEXES 1
 #define configUSE_APPLICATION_TASK_TAG 0
 #define configUSE_COUNTING_SEMAPHORES 1
+#ifdef ROVER_PROFILE_RELEASE
+#define configQUEUE_REGISTRY_SIZE 0
+#else
 #define configQUEUE_REGISTRY_SIZE 8
+#endif
 #define configUSE_QUEUE_SETS 1
 #define configUSE_TIME_SLICING 1
 #define configUSE_NEWLIB_REENTRANT 0
@@ -78,7 +82,11 @@
 #define configAPPLICATION_ALLOCATED_HEAP 0
 
 /* Hook function related definitions. */
+#ifdef ROVER_PROFILE_RELEASE
+#define configCHECK_FOR_STACK_OVERFLOW 0 /* no stack check on every context switch, use a debug build to find overflows */
+#else
 #define configCHECK_FOR_STACK_OVERFLOW 1
+#endif
 #define configUSE_MALLOC_FAILED_HOOK 0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK 0
 
@@ -0,0 +1,49 @@
+#ifndef _BOOT_PROFILE_H
+#define _BOOT_PROFILE_H
+
+#include <stdint.h>
+
+/// @brief Boot stage timings in microseconds since reset. Each stage is written by the one task
+/// that runs it, so stages on the drive side and the network side can overlap on both cores.
+namespace BootProfile
+{
+    enum class Stage : uint8_t
+    {
+        Startup,       // main(), before the scheduler
+        Battery,
+        Lights,
+        Services,      // terminal, log, input capture
+        Drivetrain,
+        Control,       // trajectory follower, link loss
+        Communication, // sense board SPI link
+        Radio,         // wifi join, network task
+        NetworkTables,
+        Driverstation,
+        Xbox,
+        Telemetry,
+        Count
+    };
+
+    enum class Milestone : uint8_t
+    {
+        DriveReady,   // drivetrain stopped and SPI link up, control loop running
+        NetworkReady, // driver station, Xbox and telemetry handed to the control loop
+        FirstCommand, // first control iteration that drove from an Xbox or trajectory command
+        Count
+    };
+
+    /// @brief Registers the boot terminal command
+    void init();
+
+    void begin(Stage stage);
+    void end(Stage stage);
+
+    /// @brief Records when a milestone was reached, later calls are ignored
+    void reached(Milestone milestone);
+    bool hasReached(Milestone milestone);
+    uint32_t getMilestoneUs(Milestone milestone);
+
+    void print();
+}
+
+#endif
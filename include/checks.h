@@ -0,0 +1,40 @@
+#ifndef _CHECKS_H
+#define _CHECKS_H
+
+#include <stdint.h>
+
+/// @brief Pass/fail checks of the drive math with explicit tolerances. No hardware dependencies:
+/// `diag` runs them on the rover and tools/checks runs them as ctest tests on a host.
+namespace Checks
+{
+    // Fixed-point against float wheel speeds over the full Xbox input range, in Q16.16 LSB (1.5e-5 m/s)
+    static constexpr int32_t KINEMATICS_MAX_ERROR_LSB = 8;
+
+    // Closed loop step to VELOCITY_SETPOINT on the sagging, loaded plant
+    static constexpr float VELOCITY_SETPOINT = 0.6f;      // m/s
+    static constexpr float VELOCITY_MAX_ERROR = 0.01f;    // m/s, steady state after VELOCITY_SIM_SECONDS
+    static constexpr float VELOCITY_MAX_RISE_TIME = 0.2f; // s, to 90 % of the setpoint
+    static constexpr float VELOCITY_MAX_OVERSHOOT = 0.05f; // fraction of the setpoint
+    static constexpr float VELOCITY_SIM_SECONDS = 2.0f;
+
+    struct KinematicsResult
+    {
+        int32_t maxErrorLsb;
+        int samples;
+        bool pass;
+    };
+
+    struct StepResponse
+    {
+        float finalVelocity; // m/s
+        float error;         // m/s, setpoint minus final
+        float riseTime;      // s, negative if never reached
+        float overshoot;     // fraction of the setpoint
+        bool pass;           // closed loop only, feedforward alone is expected to fall short
+    };
+
+    KinematicsResult kinematics();
+    StepResponse velocityStep(bool closedLoop);
+}
+
+#endif
@@ -2,6 +2,9 @@
 #define _COMMUNICATION_H
 
 #include <pico/stdlib.h>
+#include <array>
+
+#include "mailbox.h"
 
 struct CommunicationStatus
 {
@@ -37,6 +40,14 @@ struct CommunicationControl
     uint8_t data[Communication_DataSize - 1]; // rest is host data
 };
 
+struct CommunicationStats
+{
+    uint32_t transfers;
+    uint32_t failures;
+    uint32_t lastTransferUs;
+    uint32_t maxTransferUs;
+};
+
 class Communication
 {
 public:
@@ -47,7 +58,25 @@ public:
     bool read(const CommunicationControl &control, CommunicationStatus *out_status, CommunicationDistanceSensors *out_sensors);
     bool write(const CommunicationStatus &status, const CommunicationDistanceSensors &sensors, CommunicationControl *out_control);
 
+    /// @brief Status and sensor wire layout, shared by read, write and the benchmarks
+    static void pack(const CommunicationStatus &status, const CommunicationDistanceSensors &sensors, uint8_t *buffer);
+    static void unpack(const uint8_t *buffer, CommunicationStatus *out_status, CommunicationDistanceSensors *out_sensors);
+
+    const CommunicationStats &getStats()
+    {
+        return stats;
+    }
+
 private:
+    bool transfer(const uint8_t *out, uint8_t *in);
+
+    CommunicationStats stats;
+
+    // sense board frames from InputCapture replay, stand in for transfers while replaying
+    Mailbox<std::array<uint8_t, Communication_DataSize>> replayFrame;
+    std::array<uint8_t, Communication_DataSize> replayBuffer;
+    uint32_t replaySequence;
+
     bool isMain;
     uint baudrate;
 };
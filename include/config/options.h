@@ -12,7 +12,10 @@
 
 #include <math/units.h>
 #include <math/vectors.h>
+#include "math/fixedunits.h"
 #include "subsystems/moduleconfig.h"
+#include "control/linkloss.h"
+#include "control/velocitycontroller.h"
 
 namespace Config
 {
@@ -29,6 +32,55 @@ namespace Config
     {
         static constexpr uint32_t UPDATE_TIME_MS = 1000 / 40; // 40 Hz
         static constexpr int64_t UPDATE_TIME_US = 1000 * UPDATE_TIME_MS;
+
+        // NetworkTables publisher: high priority entries flush on change (coalesced),
+        // the others go out with the next flush once their period has passed
+        static constexpr uint32_t NT_MIN_FLUSH_INTERVAL_MS = UPDATE_TIME_MS;
+        static constexpr uint32_t NT_NORMAL_PERIOD_MS = 100;
+        static constexpr uint32_t NT_LOW_PERIOD_MS = 500;
+
+        // Connectionless telemetry broadcast (see control/telemetry.h for the frame layout)
+        static constexpr int TELEMETRY_PORT = 5003;
+        static constexpr const char *TELEMETRY_ADDRESS = "255.255.255.255";
+        static constexpr uint32_t TELEMETRY_PERIOD_MS = 20; // 50 Hz
+    }
+
+    namespace Logging
+    {
+        static constexpr uint RING_LENGTH = 64;    // entries per core, power of two
+        static constexpr uint HISTORY_LENGTH = 32; // formatted entries kept for 'log dump'
+        static constexpr uint32_t RATE_LIMIT_US = 1000 * 1000; // per call site
+        static constexpr uint32_t FLUSH_PERIOD_MS = 50;
+    }
+
+    namespace FlightRecorder
+    {
+        static constexpr uint RECORD_COUNT = 512; // ~10 s of main loop iterations
+        static constexpr uint RECORDS_PER_PACKET = 32;
+    }
+
+    namespace Store
+    {
+        // A/B config sectors, just below the last two that the SDK keeps for BTstack bank storage
+        static constexpr uint32_t FLASH_SECTORS_FROM_END = 4;
+        static constexpr uint32_t FLASH_TIMEOUT_MS = 100; // waiting for the other core to park
+        static constexpr uint32_t REBOOT_DELAY_MS = 250;  // Driverstation ConfigAction::Reboot
+        static constexpr uint32_t FLASH_ERASE_MAX_MS = 400; // sector erase worst case, the failsafe deadline and watchdog are stretched by this plus FLASH_TIMEOUT_MS
+        static constexpr uint32_t DRIVE_SETTLE_MS = 40;     // two control loop iterations with the drivetrain held before a write
+    }
+
+    namespace Failsafe
+    {
+        // Fed every control loop iteration (20 ms). A missed deadline stops the motors from the
+        // alarm IRQ, the watchdog then resets the chip (or stops them by itself if IRQs are blocked).
+        static constexpr uint32_t DEADLINE_US = 100 * 1000;
+        static constexpr uint32_t WATCHDOG_TIMEOUT_MS = 500;
+    }
+
+    namespace Capture
+    {
+        static constexpr uint BUFFER_SIZE = 32 * 1024; // ~10 s of Xbox, SPI and driverstation input
+        static constexpr uint DUMP_LINE_BYTES = 32;
     }
 
     namespace Control
@@ -36,9 +88,27 @@ namespace Config
         using namespace std::literals;
         static constexpr int DRIVERSTATION_PORT = 5002;
         static constexpr std::string_view DRIVERSTATION_PROTOCOL = "driverstation.pico.rover"sv;
-        static constexpr uint32_t DRIVERSTATION_TIMEOUT_MS = 1000;
+        static constexpr uint32_t DRIVERSTATION_TIMEOUT_MS = 1000;   // ping interval and pong timeout
+        static constexpr uint32_t DRIVERSTATION_SERVICE_MS = 100;    // ping and timeout check granularity
+        static constexpr uint32_t DRIVERSTATION_QUEUE_LENGTH = 16; // per dispatch class
 
         static constexpr int XBOX_UDP_PORT = 5001;
+        // Decode Xbox packets in a lwIP raw udp_recv callback instead of through the socket API
+        static constexpr bool XBOX_RAW_RECEIVE = true;
+
+        // Link loss policy (applied after UDPXbox::MAX_PACKET_INTERVAL_US without a packet)
+        static constexpr int64_t LINK_HOLD_US = 100 /* ms */ * 1000 /* ms to us */;
+        static constexpr int64_t LINK_DECAY_US = 300 /* ms */ * 1000 /* ms to us */;
+        static constexpr DecayProfile LINK_DECAY_PROFILE = DecayProfile::Quadratic;
+
+        // Trajectory follower (Ramsete), constraints used when an upload leaves them at 0
+        static constexpr float RAMSETE_B = 2.0f;
+        static constexpr float RAMSETE_ZETA = 0.7f;
+        static constexpr float TRAJECTORY_MAX_VELOCITY = 0.8f;               // m/s
+        static constexpr float TRAJECTORY_MAX_ACCELERATION = 1.0f;           // m/s^2
+        static constexpr float TRAJECTORY_MAX_CENTRIPETAL_ACCELERATION = 1.0f; // m/s^2
+        // Xbox input above this cancels a running trajectory
+        static constexpr float TRAJECTORY_OVERRIDE_DEADBAND = 0.1f;
     }
 
     namespace Drivetrain
@@ -46,10 +116,43 @@ namespace Config
         static constexpr Units ROBOT_WHEEL_DISTANCE = Units<float>::inches(14.5);
         static constexpr Units WHEEL_DIAMETER = Units<float>::inches(4.75);
 
+        // No encoders are wired yet, so both modules run VELOCITY_GAINS feedforward only (append
+        // encoderPinA, encoderPinB and counts per revolution once they are fitted)
         static constexpr ModuleConfig LEFT_CONSTANTS = ModuleConfig(18U, 17U, 13U, 14U, 19U, 20U, WHEEL_DIAMETER);
         static constexpr ModuleConfig RIGHT_CONSTANTS = ModuleConfig(12U, 11U, 21U, 22U, 16U, 15U, WHEEL_DIAMETER);
 
         static constexpr Units ROBOT_MAX_SPEED = Units<float>::meters(1);
+
+        // Run the drive kinematics in Q16.16 fixed point instead of soft float
+        static constexpr bool FIXED_POINT_KINEMATICS = true;
+        static constexpr FixedUnitsQ16 ROBOT_WHEEL_DISTANCE_FIXED = FixedUnitsQ16::meters(ROBOT_WHEEL_DISTANCE.meters());
+        static constexpr FixedUnitsQ16 ROBOT_MAX_SPEED_FIXED = FixedUnitsQ16::meters(ROBOT_MAX_SPEED.meters());
+
+        // Motor PWM
+        static constexpr uint16_t PWM_WRAP = 0xFFFF;
+        static constexpr float PWM_CLKDIV = 4.f;
+        // Counts before wrap in which a commit waits for the next period
+        static constexpr uint16_t PWM_COMMIT_GUARD = 256;
+        // A commit waits at most the length of the guard window (~5 us) for it to pass (a stopped slice never leaves it)
+        static constexpr uint32_t PWM_COMMIT_TIMEOUT_US = (uint32_t)(PWM_COMMIT_GUARD * PWM_CLKDIV / SYS_CLK_MHZ) + 1;
+
+        // Output ramp loop (DriveOutput), runs on its own core
+        static constexpr uint32_t OUTPUT_PERIOD_MS = 1; // 1 kHz
+        static constexpr uint OUTPUT_CORE = 1;
+        static constexpr float MAX_ACCELERATION = 4.0f; // m/s^2
+        static constexpr float MAX_DECELERATION = 8.0f; // m/s^2
+        static constexpr q16_16 OUTPUT_PERIOD_FIXED = q16_16::fromFloat(OUTPUT_PERIOD_MS / 1000.0f);
+
+        // Per module velocity control, feedback terms only apply to modules with an encoder
+        static constexpr VelocityGains VELOCITY_GAINS = {
+            q16_16::fromFloat(0.0f),  // kS
+            q16_16::fromFloat(1.0f),  // kV, full duty at ROBOT_MAX_SPEED
+            q16_16::fromFloat(0.8f),  // kP
+            q16_16::fromFloat(4.0f),  // kI
+            q16_16::fromFloat(0.3f)}; // integralLimit
+
+        // Odometry history sample spacing (Odometry::HISTORY_SIZE samples kept)
+        static constexpr uint64_t ODOMETRY_HISTORY_PERIOD_US = 4 /* ms */ * 1000 /* ms to us */;
     }
 
     namespace Lights
@@ -63,12 +166,39 @@ namespace Config
 
         static constexpr uint BLINK_LENGTH = 1000000;
         static constexpr uint BLINK_ON_LENGTH = 250000;
+
+        // Output level = input^GAMMA_EXPONENT, computed at compile time
+        static constexpr int GAMMA_EXPONENT = 2;
+        // Status LED update interval while it is ramping between keyframes
+        static constexpr uint ANIMATION_TICK_MS = 2;
     }
 
     namespace Battery
     {
         static constexpr uint PING_PIN = 8;
         static constexpr int32_t PING_TIMER_DELAY_MS = -1000;
+
+        // Pack voltage through an external divider (GPIO29/VSYS is shared with the wifi chip).
+        // Off until the divider is fitted, a floating SENSE_PIN reads an arbitrary voltage.
+        static constexpr bool ENABLED = false;
+        static constexpr uint SENSE_PIN = 28;
+        static constexpr uint SENSE_ADC_INPUT = 2;
+        static constexpr float SENSE_DIVIDER = 11.0f; // 100k / 10k
+        static constexpr float ADC_REFERENCE = 3.3f;
+        static constexpr uint SAMPLE_RATE_HZ = 2000;
+
+        // Samples averaged for the live voltage (16 ms)
+        static constexpr uint FAST_WINDOW = 32;
+        // Resting voltage filter, sag is resting minus live voltage
+        static constexpr float SLOW_TIME_CONSTANT_S = 2.0f;
+
+        static constexpr float NOMINAL_VOLTAGE = 11.1f;
+        static constexpr float BROWNOUT_VOLTAGE = 9.6f;
+        static constexpr float BROWNOUT_HYSTERESIS = 0.3f;
+        // Outside this range the reading is not a 3S pack (USB power, missing divider), no compensation is applied
+        static constexpr float MIN_SENSE_VOLTAGE = 5.0f;
+        static constexpr float MAX_SENSE_VOLTAGE = 13.5f;
+        static constexpr float MAX_COMPENSATION = 1.5f;
     }
 
     struct RobotProperties
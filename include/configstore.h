@@ -0,0 +1,82 @@
+#ifndef _CONFIG_STORE_H
+#define _CONFIG_STORE_H
+
+#include <stdint.h>
+#include "control/velocitycontroller.h"
+
+/// @brief Field tunables, stored in flash exactly as laid out here and read in place.
+/// Append fields and bump ConfigStore::VERSION when the layout changes.
+struct StoredConfig
+{
+    float wheelDistance;   // m
+    float maxSpeed;        // m/s
+    float maxAcceleration; // m/s^2
+    float maxDeceleration; // m/s^2
+
+    // VelocityGains as raw q16_16
+    int32_t velocityKS;
+    int32_t velocityKV;
+    int32_t velocityKP;
+    int32_t velocityKI;
+    int32_t velocityIntegralLimit;
+
+    float ramseteB;
+    float ramseteZeta;
+    float trajectoryMaxVelocity;                // m/s
+    float trajectoryMaxAcceleration;            // m/s^2
+    float trajectoryMaxCentripetalAcceleration; // m/s^2
+    float trajectoryOverrideDeadband;
+
+    uint32_t linkHoldUs;
+    uint32_t linkDecayUs;
+
+    VelocityGains velocityGains() const
+    {
+        return {q16_16::fromRaw(velocityKS), q16_16::fromRaw(velocityKV), q16_16::fromRaw(velocityKP), q16_16::fromRaw(velocityKI), q16_16::fromRaw(velocityIntegralLimit)};
+    }
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(wheelDistance, maxSpeed, maxAcceleration, maxDeceleration,
+             velocityKS, velocityKV, velocityKP, velocityKI, velocityIntegralLimit,
+             ramseteB, ramseteZeta, trajectoryMaxVelocity, trajectoryMaxAcceleration, trajectoryMaxCentripetalAcceleration, trajectoryOverrideDeadband,
+             linkHoldUs, linkDecayUs);
+    }
+};
+
+enum class ConfigSource : uint8_t
+{
+    Defaults, // compiled in, config/options.h
+    SlotA,
+    SlotB
+};
+
+/// @brief Versioned config blob in two reserved flash sectors (A/B), memory mapped through XIP.
+/// Boot picks the valid slot with the highest sequence and hands out a reference into flash, with
+/// no copy or decoding. Writes always go to the other slot, so the running one is never erased
+/// and a write cut short by a reset leaves the previous config in place.
+namespace ConfigStore
+{
+    static constexpr uint32_t MAGIC = 0x47464352; // RCFG
+    static constexpr uint16_t VERSION = 1;
+
+    void init();
+
+    /// @brief Config loaded at boot. Consumers read it when they are constructed, writes apply after a reboot.
+    const StoredConfig &get();
+    const StoredConfig &getDefaults();
+
+    ConfigSource getSource();
+    uint32_t getSequence();
+    /// @brief True once a newer config has been written this session
+    bool isPending();
+
+    /// @brief Range checks a config before it is written
+    bool validate(const StoredConfig &config);
+
+    /// @brief Validates and programs config into the slot not in use
+    bool write(const StoredConfig &config);
+}
+
+#endif
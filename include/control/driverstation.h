@@ -3,13 +3,27 @@
 
 #include <wsserver.h>
 #include <unordered_map>
+#include <optional>
 #include <pico/stdlib.h>
 #include <pico/time.h>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <queue.h>
+#include <pico/critical_section.h>
+#include "subsystems/odometry.h"
+#include "subsystems/drivetrain.h"
+#include "control/trajectoryfollower.h"
+#include "configstore.h"
 
 enum class PacketType : uint8_t
 {
     ClockSync,
-    RobotProperties
+    RobotProperties,
+    Pose,
+    Trajectory,
+    TrajectoryStatus,
+    FlightRecord,
+    Config
 };
 
 struct ClockSyncRequestPacket
@@ -35,25 +49,230 @@ struct ClockSyncPacket
     }
 };
 
+struct PoseRequestPacket
+{
+    uint64_t serverTime; // pose at this time, 0 for the latest
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(serverTime);
+    }
+};
+
+struct PosePacket
+{
+    uint64_t serverTime;
+    float x;
+    float y;
+    float heading;
+
+    template <class T>
+    void pack(T &pack) const
+    {
+        pack(serverTime, x, y, heading);
+    }
+};
+
+struct TrajectoryPacket
+{
+    float maxVelocity;                // m/s, 0 for the default
+    float maxAcceleration;            // m/s^2, 0 for the default
+    float maxCentripetalAcceleration; // m/s^2, 0 for the default
+    bool relative;                    // waypoints relative to the current pose
+    std::vector<float> waypoints;     // x0, y0, x1, y1, ... (m), empty to cancel
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(maxVelocity, maxAcceleration, maxCentripetalAcceleration, relative, waypoints);
+    }
+};
+
+struct TrajectoryStatusPacket
+{
+    uint64_t serverTime;
+    bool active;
+    float time;
+    float totalTime;
+    float alongError;
+    float crossError;
+    float headingError;
+
+    template <class T>
+    void pack(T &pack) const
+    {
+        pack(serverTime, active, time, totalTime, alongError, crossError, headingError);
+    }
+};
+
+enum class FlightRecordAction : uint8_t
+{
+    Read,
+    Freeze,
+    Resume
+};
+
+struct FlightRecordRequestPacket
+{
+    uint8_t action; // FlightRecordAction
+    uint32_t first; // oldest record is 0
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(action, first);
+    }
+};
+
+struct FlightRecordPacket
+{
+    uint8_t freezeReason; // FreezeReason
+    uint32_t count;       // records available
+    uint32_t first;
+    std::vector<uint8_t> records; // raw little-endian FlightRecord structs
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(freezeReason, count, first, records);
+    }
+};
+
+enum class ConfigAction : uint8_t
+{
+    Read,
+    Write,  // store config, applies after a reboot
+    Reset,  // store the compiled defaults, applies after a reboot
+    Reboot  // restart shortly after the response went out
+};
+
+struct ConfigRequestPacket
+{
+    uint8_t action; // ConfigAction
+    StoredConfig config; // Write only
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(action, config);
+    }
+};
+
+struct ConfigPacket
+{
+    uint8_t source;    // ConfigSource of the running config
+    uint32_t sequence; // of the running config, 0 for the defaults
+    bool pending;      // a newer config is stored and waits for a reboot
+    StoredConfig config; // running config
+
+    template <class T>
+    void pack(T &pack)
+    {
+        pack(source, sequence, pending, config);
+    }
+};
+
+/// @brief Dispatch order for incoming packets and outgoing frames, Realtime first
+enum class DispatchClass : uint8_t
+{
+    Realtime, // ClockSync, the offset estimate depends on a short, steady turnaround
+    Normal,   // poses and trajectories
+    Bulk,     // RobotProperties, flight records and error strings
+    Count
+};
+
+struct DispatchStats
+{
+    uint32_t depth; // filled in by getStats
+    uint32_t maxDepth;
+    uint32_t queued;
+    uint32_t dropped; // queue full
+    uint32_t handled;
+    uint32_t lastWaitUs;
+    uint32_t maxWaitUs;
+    uint64_t totalWaitUs;
+};
+
 class Driverstation
 {
+    friend void driverstation_dispatch_task(void *pv_driverstation);
+
 public:
     Driverstation();
     ~Driverstation();
 
+    WsServer *server;
+
+    /// @brief Queues a packet for every connected client
+    void broadcast(PacketType type, std::vector<uint8_t> data);
+
+    void setOdometry(Odometry *odometry)
+    {
+        this->odometry = odometry;
+    }
+    void publishPose();
+
+    void setTrajectoryFollower(TrajectoryFollower *follower)
+    {
+        this->follower = follower;
+    }
+    void publishTrajectoryStatus();
+
+    /// @brief Config writes are refused unless this drivetrain is stopped
+    void setDrivetrain(Drivetrain *drivetrain)
+    {
+        this->drivetrain = drivetrain;
+    }
+
+    DispatchStats getStats(DispatchClass dispatchClass);
+
+private:
+    struct DispatchItem
+    {
+        bool incoming; // received from guid, otherwise to be sent to guid
+        bool text;
+        std::optional<Guid> guid; // empty to send to every client
+        std::vector<uint8_t> data;
+        uint32_t queuedUs;
+    };
+
     struct ClientData
     {
-        alarm_id_t pongTimeoutAlarm;
-        alarm_id_t pingIntervalAlarm;
+        uint64_t pingDueUs;      // next ping, 0 while a pong is awaited
+        uint64_t pongDeadlineUs; // disconnect without a pong by then, 0 if none is awaited
     };
 
+    /// @brief Pings clients that are due and disconnects the silent ones (dispatch task only)
+    void serviceClients();
+    bool hasClients();
+
+    /// @brief Holds the drivetrain if it is stopped and stays stopped, see Drivetrain::setHold
+    /// @return False (and not held) if it is moving, following a trajectory or there is none
+    bool holdDrive();
+
+    bool enqueue(DispatchClass dispatchClass, DispatchItem *item);
+    void dispatch(DispatchItem *item);
+
+    void handleFrame(const Guid &guid, const uint8_t *payload, size_t payloadLength);
+    void send(const Guid &guid, PacketType type, std::vector<uint8_t> data);
+    void sendText(const Guid &guid, std::string text);
+
+    Odometry *odometry;
+    TrajectoryFollower *follower;
+    Drivetrain *drivetrain;
+
     std::unordered_map<Guid, ClientData> clients;
-    WsServer *server;
+    SemaphoreHandle_t clientsMutex; // clients, task context only
+    uint64_t nextServiceUs;
 
-    void ping(const Guid &guid);
-    void handleFrame(const Guid &guid, const WebSocketFrame &frame);
+    QueueHandle_t queues[(int)DispatchClass::Count];
+    DispatchStats stats[(int)DispatchClass::Count];
+    critical_section_t statsLock;
 
-private:
+    TaskHandle_t dispatchTask;
+    volatile bool running;
+    volatile bool exited;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef _LINK_LOSS_H
+#define _LINK_LOSS_H
+
+#include <stdint.h>
+#include <pico/stdlib.h>
+#include <math/units.h>
+
+enum class LinkLossPhase : uint8_t
+{
+    Connected, // packets arriving within the allowed interval
+    Hold,      // last command held unchanged
+    Decay,     // last command scaled down towards zero
+    Stopped    // hard stop until the link recovers
+};
+
+enum class DecayProfile : uint8_t
+{
+    Step,     // no decay, stop right after the hold window
+    Linear,   // command falls linearly over the decay window
+    Quadratic // command falls quickly at first, then eases into the stop
+};
+
+struct LinkLossStats
+{
+    uint32_t holds;
+    uint32_t decays;
+    uint32_t stops;
+    uint32_t recoveries; // link came back during hold or decay
+};
+
+class LinkLossPolicy
+{
+public:
+    LinkLossPolicy(int64_t connectedUs, int64_t holdUs, int64_t decayUs, DecayProfile profile);
+
+    /// @brief Advances the policy with the current packet age.
+    /// @param packetAgeUs Time since the last accepted packet
+    /// @param forward Live forward command, latched while connected
+    /// @param rotation Live rotation command, latched while connected
+    /// @return True if the drivetrain should be driven with getForward/getRotation, false if it should stop
+    bool update(int64_t packetAgeUs, Units<float> forward, Units<float> rotation);
+
+    Units<float> getForward()
+    {
+        return Units<float>::meters(lastForward.meters() * scale);
+    }
+    Units<float> getRotation()
+    {
+        return Units<float>::radians(lastRotation.radians() * scale);
+    }
+
+    LinkLossPhase getPhase()
+    {
+        return phase;
+    }
+
+    const LinkLossStats &getStats()
+    {
+        return stats;
+    }
+
+private:
+    void enterPhase(LinkLossPhase next);
+
+    int64_t connectedUs;
+    int64_t holdUs;
+    int64_t decayUs;
+    DecayProfile profile;
+
+    LinkLossPhase phase;
+    LinkLossStats stats;
+
+    Units<float> lastForward;
+    Units<float> lastRotation;
+    float scale;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef _RAW_UDP_SOCKET_H
+#define _RAW_UDP_SOCKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <lwip/udp.h>
+
+struct RawDatagram
+{
+    const uint8_t *data; // valid only during the callback
+    size_t length;
+    uint32_t remoteAddress; // network byte order
+    uint16_t remotePort;
+};
+
+/// @brief UDP receiver on the lwIP raw API. Datagrams are handed to receiveCallback straight
+/// from the pbuf on the tcpip thread, without the socket mailbox and copy. Keep callbacks short.
+class RawUdpSocket
+{
+public:
+    RawUdpSocket(int port);
+    ~RawUdpSocket();
+
+    bool isBound()
+    {
+        return pcb != nullptr;
+    }
+
+    uint32_t getReceived()
+    {
+        return received;
+    }
+
+    void *callbackArgs;
+    void (*receiveCallback)(RawUdpSocket *socket, const RawDatagram *datagram, void *args);
+
+private:
+    static void receive(void *arg, udp_pcb *pcb, pbuf *p, const ip_addr_t *addr, u16_t port);
+
+    udp_pcb *pcb;
+    volatile uint32_t received;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _SIMULATED_MOTOR_H
+#define _SIMULATED_MOTOR_H
+
+#include "math/fixed.h"
+#include "control/velocitysensor.h"
+
+struct SimulatedMotorParameters
+{
+    float freeSpeed;      // wheel m/s at full duty and nominal voltage
+    float timeConstant;   // s, first order mechanical time constant
+    float frictionDuty;   // duty needed before the wheel moves
+    float supplyRatio;    // actual / nominal battery voltage
+    float loadSpeedDrop;  // m/s lost to load at steady state
+};
+
+/// @brief First order DC motor and wheel plant, used to validate VelocityController gains and
+/// loop timing without hardware. Plain float math, no hardware dependencies.
+class SimulatedMotor : public VelocitySensor
+{
+public:
+    SimulatedMotor(const SimulatedMotorParameters &parameters) : parameters(parameters), velocity(0.0f)
+    {
+    }
+
+    /// @brief Advances the plant by dt seconds with the given duty applied
+    void step(q16_16 duty, float dt)
+    {
+        float d = duty.toFloat();
+        float effective = 0.0f;
+        if (d > parameters.frictionDuty)
+            effective = d - parameters.frictionDuty;
+        else if (d < -parameters.frictionDuty)
+            effective = d + parameters.frictionDuty;
+
+        float target = effective * parameters.freeSpeed * parameters.supplyRatio;
+        if (target > 0.0f)
+            target = target > parameters.loadSpeedDrop ? target - parameters.loadSpeedDrop : 0.0f;
+        else if (target < 0.0f)
+            target = target < -parameters.loadSpeedDrop ? target + parameters.loadSpeedDrop : 0.0f;
+
+        float alpha = dt / (parameters.timeConstant + dt);
+        velocity += (target - velocity) * alpha;
+    }
+
+    bool read(q16_16 &out) override
+    {
+        out = q16_16::fromFloat(velocity);
+        return true;
+    }
+
+    float getVelocity()
+    {
+        return velocity;
+    }
+
+    SimulatedMotorParameters parameters;
+
+private:
+    float velocity;
+};
+
+#endif
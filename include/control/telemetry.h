@@ -0,0 +1,77 @@
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <stdint.h>
+#include <pico/stdlib.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "mailbox.h"
+#include "flightrecorder.h"
+#include "subsystems/odometry.h"
+
+/// @brief One UDP datagram, little-endian. Listeners check magic and version, and use the
+/// sequence number to detect loss and reordering.
+struct __attribute__((packed)) TelemetryFrame
+{
+    static constexpr uint16_t MAGIC = 0x5254; // "TR" on the wire
+    static constexpr uint8_t VERSION = 1;
+
+    uint16_t magic;
+    uint8_t version;
+    uint8_t size; // bytes in the whole frame
+    uint32_t sequence;
+    uint64_t timeUs; // same clock as the driverstation ClockSync packets
+
+    int32_t x;       // q16.16 m
+    int32_t y;       // q16.16 m
+    int32_t heading; // q16.16 rad
+    FlightRecord record;
+};
+
+static_assert(sizeof(TelemetryFrame) == 68, "TelemetryFrame layout is part of the telemetry protocol");
+
+struct TelemetryStats
+{
+    uint32_t sent;
+    uint32_t errors;
+};
+
+/// @brief Fire-and-forget telemetry broadcast at a fixed rate, no per-listener state
+class Telemetry
+{
+    friend void telemetry_task(void *pv_telemetry);
+
+public:
+    Telemetry();
+    ~Telemetry();
+
+    /// @brief Hands the latest state to the broadcast task (lock-free, any task)
+    void post(const Pose &pose, const FlightRecord &record);
+
+    const TelemetryStats &getStats()
+    {
+        return stats;
+    }
+
+private:
+    struct Snapshot
+    {
+        Pose pose;
+        FlightRecord record;
+    };
+
+    void send(const Snapshot &snapshot);
+
+    int socket;
+    uint32_t sequence;
+
+    Mailbox<Snapshot> mailbox;
+
+    TaskHandle_t task;
+    volatile bool running;
+    volatile bool exited;
+
+    TelemetryStats stats;
+};
+
+#endif
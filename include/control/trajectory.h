@@ -0,0 +1,66 @@
+#ifndef _TRAJECTORY_H
+#define _TRAJECTORY_H
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+struct TrajectoryConstraints
+{
+    float maxVelocity;             // m/s
+    float maxAcceleration;         // m/s^2
+    float maxCentripetalAcceleration; // m/s^2
+};
+
+struct TrajectoryState
+{
+    float time;      // s since start
+    float x;         // m
+    float y;         // m
+    float heading;   // rad
+    float velocity;  // m/s
+    float curvature; // rad/m
+};
+
+/// @brief Wraps an angle to [-pi, pi)
+inline float wrap_angle(float angle)
+{
+    angle = fmodf(angle + (float)M_PI, 2.0f * (float)M_PI);
+    return angle < 0.0f ? angle + (float)M_PI : angle - (float)M_PI;
+}
+
+/// @brief Time parameterized path through a list of waypoints.
+/// The path is a Catmull-Rom spline, sampled once on load with a forward/backward pass
+/// velocity profile, so sampling at the control rate is a lookup and a lerp.
+class Trajectory
+{
+public:
+    static constexpr uint32_t SAMPLES_PER_SEGMENT = 16;
+    static constexpr uint32_t MAX_SAMPLES = 512;
+    // m, half the Q16.16 pose range so the difference of two positions is representable too
+    static constexpr float MAX_COORDINATE = 16384.0f;
+
+    /// @brief Builds the trajectory, waypoints are x/y pairs in meters
+    /// @return False if there are fewer than two waypoints, too many samples, a non-finite waypoint
+    /// or a constraint that is not finite and positive
+    bool generate(const std::vector<float> &waypoints, const TrajectoryConstraints &constraints);
+
+    /// @brief State at a time, clamped to the end of the trajectory
+    TrajectoryState sample(float time);
+
+    float getTotalTime()
+    {
+        return states.empty() ? 0.0f : states.back().time;
+    }
+
+    bool isEmpty()
+    {
+        return states.empty();
+    }
+
+private:
+    std::vector<TrajectoryState> states;
+    uint32_t cursor; // last sampled index, sampling time only moves forward
+};
+
+#endif
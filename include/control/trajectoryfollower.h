@@ -0,0 +1,65 @@
+#ifndef _TRAJECTORY_FOLLOWER_H
+#define _TRAJECTORY_FOLLOWER_H
+
+#include <stdint.h>
+#include <vector>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "control/trajectory.h"
+#include "subsystems/odometry.h"
+
+struct TrajectoryTracking
+{
+    bool active;
+    float time;         // s into the trajectory
+    float totalTime;    // s
+    float alongError;   // m, positive when behind the reference
+    float crossError;   // m, positive when right of the reference
+    float headingError; // rad
+};
+
+struct RamseteGains
+{
+    float b;    // convergence aggressiveness, > 0
+    float zeta; // damping, in (0, 1)
+};
+
+/// @brief Follows an uploaded Trajectory on board with a Ramsete controller against odometry
+class TrajectoryFollower
+{
+public:
+    TrajectoryFollower();
+    ~TrajectoryFollower();
+
+    /// @brief Generates and arms a trajectory (safe to call from any task)
+    /// @param relative Waypoints are relative to origin instead of the odometry frame
+    bool load(const std::vector<float> &waypoints, const TrajectoryConstraints &constraints, bool relative, const Pose &origin);
+    void cancel();
+    /// @brief True while a trajectory is loaded or being followed
+    bool isFollowing();
+
+    /// @brief Samples the trajectory and computes the drive command (control loop only)
+    /// @return True while a trajectory is being followed
+    bool update(const Pose &pose, uint64_t timeUs, float &forward, float &rotation);
+
+    TrajectoryTracking getTracking();
+
+    /// @brief Live controller gains (terminal tunables), each field is read once per update
+    RamseteGains &getGains()
+    {
+        return gains;
+    }
+
+private:
+    SemaphoreHandle_t mutex;
+
+    Trajectory *trajectory;
+    bool pending; // loaded, starts on the next update
+    bool active;
+    uint64_t startUs;
+
+    TrajectoryTracking tracking;
+    RamseteGains gains;
+};
+
+#endif
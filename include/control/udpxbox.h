@@ -2,6 +2,7 @@
 #define _UDP_XBOX_H
 
 #include <udpsocket.h>
+#include "control/rawudpsocket.h"
 #include <math/units.h>
 #include <packets/control/xbox.h>
 
@@ -15,6 +16,7 @@ public:
     Units<float> getRotation();
 
     bool isConnected();
+    int64_t getPacketAge();
 
     Control::Xbox inputs;
     absolute_time_t lastInputPacketTime;
@@ -22,7 +24,11 @@ public:
     static constexpr int64_t MAX_PACKET_INTERVAL_US = 100 /* ms */ * 1000 /* ms to us */;
 
 private:
-    UdpSocket *socket;
+    void receive(const uint8_t *data, size_t length);
+    void decode(const uint8_t *data, size_t length);
+
+    UdpSocket *socket;       // socket API path (tcpip thread -> mailbox -> copy)
+    RawUdpSocket *rawSocket; // raw API path, decodes straight from the pbuf
 };
 
 #endif
\ No newline at end of file
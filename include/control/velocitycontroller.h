@@ -0,0 +1,44 @@
+#ifndef _VELOCITY_CONTROLLER_H
+#define _VELOCITY_CONTROLLER_H
+
+#include "math/fixed.h"
+
+struct VelocityGains
+{
+    q16_16 kS; // duty to overcome static friction
+    q16_16 kV; // duty per m/s
+    q16_16 kP; // duty per m/s of error
+    q16_16 kI; // duty per m of accumulated error
+    q16_16 integralLimit; // max duty contributed by the integrator
+};
+
+/// @brief Feedforward plus PI wheel velocity controller in fixed point, run at a fixed period.
+/// Has no hardware dependencies so it can be exercised against SimulatedMotor on a host.
+class VelocityController
+{
+public:
+    VelocityController(const VelocityGains &gains, q16_16 period);
+
+    /// @brief Duty in [-1, 1] for a setpoint without feedback (feedforward only)
+    q16_16 calculate(q16_16 setpoint);
+    /// @brief Duty in [-1, 1] for a setpoint and measured velocity
+    q16_16 calculate(q16_16 setpoint, q16_16 measurement);
+
+    void reset();
+
+    q16_16 getError()
+    {
+        return error;
+    }
+
+private:
+    q16_16 feedforward(q16_16 setpoint);
+
+    VelocityGains gains;
+    q16_16 integralStep; // kI * period
+
+    q16_16 error;
+    q16_16 integral; // in duty
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _VELOCITY_SENSOR_H
+#define _VELOCITY_SENSOR_H
+
+#include "math/fixed.h"
+
+/// @brief Wheel velocity feedback (encoder, back-EMF or a simulated plant)
+class VelocitySensor
+{
+public:
+    virtual ~VelocitySensor() = default;
+
+    /// @brief Samples the wheel velocity in m/s, called once per output period
+    /// @return False if no valid measurement is available
+    virtual bool read(q16_16 &velocity) = 0;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _DIAGNOSTICS_H
+#define _DIAGNOSTICS_H
+
+namespace Diagnostics
+{
+    /// @brief Runs Checks::kinematics (PASS/FAIL against the LSB limit) and times the fixed and float paths in cycles per call
+    void kinematicsReport();
+    /// @brief Runs Checks::velocityStep open and closed loop and prints step response metrics, PASS/FAIL for the closed loop
+    void velocityControllerReport();
+    /// @brief Measures send-to-callback latency over loopback for the raw udp_recv path and the socket API path
+    /// (debug and capture profiles, release builds have no LWIP_NETIF_LOOPBACK)
+    void udpLatencyReport();
+    /// @brief Times the firmware hot paths and prints one JSON line per benchmark (us, cycles and bytes per call)
+    void benchmarkReport();
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef _FAILSAFE_H
+#define _FAILSAFE_H
+
+#include <stdint.h>
+#include "subsystems/motoroutputs.h"
+#include "subsystems/driveoutput.h"
+
+enum class FailsafeCause : uint8_t
+{
+    None,        // power on, reset pin or debugger
+    Deadline,    // control loop missed its deadline, stopped from the alarm IRQ
+    Panic,       // rtos_panic
+    HardFault,
+    Manual,      // failsafe trip on the terminal
+    Requested,   // Failsafe::reboot, e.g. driverstation ConfigAction::Reboot
+    Watchdog,    // watchdog reset without a recorded cause (interrupts blocked too long)
+    OutputStall  // the control loop ran but the drive output task stopped ticking
+};
+
+/// @brief What tripped before the last reset, kept in the watchdog scratch registers
+struct FailsafeReport
+{
+    FailsafeCause cause;
+    uint32_t timeUs; // since the previous boot
+    uint32_t lateUs; // Deadline: alarm IRQ past the deadline
+    uint32_t stopUs; // trip entry to all motor pins driven low
+};
+
+/// @brief Motor stop path that does not depend on main_task. The control loop feeds a hardware
+/// alarm deadline and the hardware watchdog while the drive output task keeps ticking; when the
+/// deadline passes, the output task stalls for as long (or on a panic or hard fault)
+/// the motor pins are taken off the PWM and driven low from interrupt context, the cause is stored
+/// for the next boot and the watchdog, no longer fed, resets the chip.
+namespace Failsafe
+{
+    /// @brief Reads and clears the cause recorded before this reset, call once early in main()
+    void init();
+
+    /// @brief Arms the deadline and enables the watchdog, from the task that runs the control loop
+    /// @param driveOutput Its ticks must advance between feeds, it writes the PWM levels
+    void start(MotorOutputs *outputs, DriveOutput *driveOutput);
+
+    /// @brief Once per control loop iteration, trips with OutputStall if the drive output stopped
+    void feed();
+
+    /// @brief Pushes the deadline out and stretches the watchdog for a known stall with interrupts
+    /// off (flash erase), the next feed after it restores the normal watchdog timeout
+    void extendDeadline(uint32_t ms);
+
+    /// @brief Stops the motors, records the cause and stops feeding the watchdog. Interrupt safe, first cause wins.
+    void trip(FailsafeCause cause);
+
+    /// @brief Deliberate watchdog reboot, recorded as FailsafeCause::Requested
+    void reboot(uint32_t delayMs);
+
+    bool isTripped();
+    const FailsafeReport &getLastReset();
+}
+
+#endif
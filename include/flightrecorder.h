@@ -0,0 +1,67 @@
+#ifndef _FLIGHT_RECORDER_H
+#define _FLIGHT_RECORDER_H
+
+#include <stdint.h>
+
+enum class RecordSource : uint8_t
+{
+    Stopped,
+    Trajectory,
+    Xbox
+};
+
+enum class FreezeReason : uint8_t
+{
+    None,
+    Manual,
+    Panic,
+    Brownout,
+    Failsafe
+};
+
+/// @brief One control iteration, fixed size so the ring is a plain array
+struct FlightRecord
+{
+    uint32_t timeUs;
+    int16_t forward;     // command, mm/s
+    int16_t rotation;    // command, mrad/s
+    int16_t leftTarget;  // mm/s
+    int16_t rightTarget; // mm/s
+    int16_t leftOutput;  // ramped, mm/s
+    int16_t rightOutput; // ramped, mm/s
+    uint16_t distances[6]; // mm, 0xFFFF if the sense board did not answer or was invalid
+    uint16_t controlUs;    // stage timings
+    uint16_t commUs;
+    uint16_t publishUs;
+    uint16_t periodUs;
+    RecordSource source;
+    uint8_t linkPhase; // LinkLossPhase
+    uint16_t batteryMillivolts;
+};
+
+static_assert(sizeof(FlightRecord) == 40, "FlightRecord layout is part of the driverstation protocol");
+
+/// @brief RAM ring of the last control iterations. It lives in uninitialized RAM, so a frozen
+/// recording survives a watchdog or debugger reset and can be read out after the reboot.
+namespace FlightRecorder
+{
+    void init();
+
+    /// @brief Appends a record unless frozen (a struct copy, no allocation)
+    void record(const FlightRecord &record);
+
+    /// @brief Stops recording and keeps the ring for read out, the first reason is kept
+    void freeze(FreezeReason reason);
+    void resume();
+
+    FreezeReason getFreezeReason();
+    bool isFrozen();
+
+    /// @brief Number of records available, oldest first
+    uint32_t getCount();
+    /// @brief Copies records [first, first + max) counted from the oldest one
+    /// @return Records copied
+    uint32_t copy(uint32_t first, FlightRecord *out, uint32_t max);
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef _INPUT_CAPTURE_H
+#define _INPUT_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// @brief Timestamped log of every inbound Xbox datagram, driverstation frame and sense board SPI
+/// frame, replayed through the same receive paths with the original spacing.
+///
+/// Log layout (little-endian): a Header, then records of a RecordHeader followed by length bytes.
+/// Driverstation records start with the client Guid.
+namespace InputCapture
+{
+    enum class Source : uint8_t
+    {
+        Xbox,
+        Driverstation,
+        Spi,
+        Count
+    };
+
+    enum class Mode : uint8_t
+    {
+        Idle,
+        Capturing,
+        Replaying
+    };
+
+    static constexpr uint32_t MAGIC = 0x50414349; // ICAP
+    static constexpr uint16_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t guidSize; // bytes in front of driverstation payloads
+        uint32_t records;
+        uint32_t bytes; // records only, without this header
+    };
+
+    struct RecordHeader
+    {
+        uint32_t timeUs; // since the capture started
+        uint16_t length;
+        uint8_t source; // Source
+        uint8_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(RecordHeader) == 8, "Capture log layout is read by host tools");
+
+    struct Stats
+    {
+        Mode mode;
+        uint32_t records;
+        uint32_t bytes;
+        uint32_t dropped; // log full
+        uint32_t replayed;
+        uint32_t lastLateUs; // replay delivery behind the captured time
+        uint32_t maxLateUs;
+    };
+
+    /// @brief Replay delivery for one source, called on the replay task
+    typedef void (*ReplayHandler)(const uint8_t *data, size_t length, void *context);
+
+    void init();
+
+    /// @brief Appends a record while capturing. prefix is written in front of data (driverstation Guid).
+    void record(Source source, const uint8_t *data, size_t length, const void *prefix = nullptr, size_t prefixLength = 0);
+
+    /// @brief Live input for a replayed source should be ignored
+    bool isReplaying();
+
+    void setReplayHandler(Source source, ReplayHandler handler, void *context);
+
+    /// @brief Clears the log and starts capturing
+    bool start();
+    /// @brief Ends a capture or replay, the log is kept
+    void stop();
+    /// @brief Feeds the log back through the replay handlers with the captured timing
+    bool replay();
+
+    Stats getStats();
+
+    /// @brief Prints the log as hex lines (xxd -r -p turns them back into a binary log)
+    void dump();
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _FIXED_DIFFERENTIAL_DRIVE_H
+#define _FIXED_DIFFERENTIAL_DRIVE_H
+
+#include "math/fixed.h"
+#include "math/fixedunits.h"
+
+template <int FractionBits>
+struct FixedChassisSpeeds
+{
+    Fixed<FractionBits> vx;    // m/s
+    Fixed<FractionBits> vy;    // m/s
+    Fixed<FractionBits> omega; // rad/s
+};
+
+template <int FractionBits>
+struct FixedDifferentialDriveWheelSpeeds
+{
+    Fixed<FractionBits> left;  // m/s
+    Fixed<FractionBits> right; // m/s
+
+    /// @brief Scales both sides down so neither exceeds maxSpeed, keeping their ratio
+    constexpr void normalize(Fixed<FractionBits> maxSpeed)
+    {
+        Fixed<FractionBits> leftAbs = left.abs();
+        Fixed<FractionBits> rightAbs = right.abs();
+        Fixed<FractionBits> realMax = leftAbs > rightAbs ? leftAbs : rightAbs;
+        if (realMax > maxSpeed)
+        {
+            Fixed<FractionBits> scale = maxSpeed / realMax;
+            left *= scale;
+            right *= scale;
+        }
+    }
+};
+
+/// @brief Fixed-point version of DifferentialDriveKinematics
+template <int FractionBits>
+class FixedDifferentialDriveKinematics
+{
+public:
+    constexpr explicit FixedDifferentialDriveKinematics(FixedUnits<FractionBits> trackWidth) : halfTrackWidth(trackWidth.meters() / 2),
+                                                                                                inverseTrackWidth(Fixed<FractionBits>::fromInt(1) / trackWidth.meters())
+    {
+    }
+
+    constexpr FixedDifferentialDriveWheelSpeeds<FractionBits> toWheelSpeeds(const FixedChassisSpeeds<FractionBits> &speeds) const
+    {
+        Fixed<FractionBits> turn = halfTrackWidth * speeds.omega;
+        return {speeds.vx - turn, speeds.vx + turn};
+    }
+
+    constexpr FixedChassisSpeeds<FractionBits> toChassisSpeeds(const FixedDifferentialDriveWheelSpeeds<FractionBits> &wheelSpeeds) const
+    {
+        return {(wheelSpeeds.left + wheelSpeeds.right) / 2, Fixed<FractionBits>(), (wheelSpeeds.right - wheelSpeeds.left) * inverseTrackWidth};
+    }
+
+private:
+    Fixed<FractionBits> halfTrackWidth;
+    Fixed<FractionBits> inverseTrackWidth;
+};
+
+#endif
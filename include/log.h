@@ -0,0 +1,88 @@
+#ifndef _LOG_H
+#define _LOG_H
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "config/options.h"
+
+/// @brief Deferred logging. Call sites only copy a descriptor pointer and raw argument words
+/// into a per-core ring; formatting and stdio happen later on a low priority task.
+namespace Log
+{
+    static constexpr int MAX_ARGS = 4;
+
+    enum class Level : uint8_t
+    {
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+
+    /// @brief Static descriptor of one LOG call site
+    struct Site
+    {
+        const char *format; // printf format, only integer, char, pointer and float conversions
+        Level level;
+        uint32_t minIntervalUs;
+        volatile uint32_t lastUs;
+        volatile uint32_t suppressed; // messages dropped by the rate limit since the last one written
+        volatile bool written;
+    };
+
+    struct Stats
+    {
+        uint32_t written;
+        uint32_t dropped;    // ring full
+        uint32_t suppressed; // rate limited
+    };
+
+    /// @brief Raw 32-bit argument word, floats are stored bit for bit
+    template <typename T>
+    inline uint32_t word(T value)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            float f = (float)value;
+            uint32_t w;
+            memcpy(&w, &f, sizeof(w));
+            return w;
+        }
+        else if constexpr (std::is_pointer_v<T>)
+            return (uint32_t)(uintptr_t)value;
+        else
+            return (uint32_t)value;
+    }
+
+    /// @brief Queues a message, never blocks (safe from any task or interrupt on either core)
+    void write(Site &site, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint32_t a3 = 0);
+
+    void start();
+    void stop();
+
+    Stats getStats();
+    void setLevel(Level level);
+    Level getLevel();
+    void setOutputEnabled(bool enabled);
+    /// @brief Prints the last Config::Logging::HISTORY_LENGTH messages again
+    void dump();
+}
+
+#define LOG(level, format, ...)                                                                      \
+    do                                                                                               \
+    {                                                                                                \
+        static Log::Site _logSite = {format, level, Config::Logging::RATE_LIMIT_US, 0, 0, false};    \
+        Log::write(_logSite __VA_OPT__(, LOG_WORDS(__VA_ARGS__)));                                   \
+    } while (0)
+
+#define LOG_WORD(x) Log::word(x)
+#define LOG_WORDS_1(a) LOG_WORD(a)
+#define LOG_WORDS_2(a, b) LOG_WORD(a), LOG_WORD(b)
+#define LOG_WORDS_3(a, b, c) LOG_WORD(a), LOG_WORD(b), LOG_WORD(c)
+#define LOG_WORDS_4(a, b, c, d) LOG_WORD(a), LOG_WORD(b), LOG_WORD(c), LOG_WORD(d)
+// more than Log::MAX_ARGS arguments expands to the undeclared LOG_TAKES_AT_MOST_4_ARGUMENTS
+#define LOG_WORDS_PICK(_1, _2, _3, _4, _5, NAME, ...) NAME
+#define LOG_WORDS(...) LOG_WORDS_PICK(__VA_ARGS__, LOG_TAKES_AT_MOST_4_ARGUMENTS, LOG_WORDS_4, LOG_WORDS_3, LOG_WORDS_2, LOG_WORDS_1)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef _MAILBOX_H
+#define _MAILBOX_H
+
+#include <stdint.h>
+#include <atomic>
+
+/// @brief Lock-free single-producer mailbox (sequence lock) holding the latest value.
+/// Readers on any core never block the producer and only ever see a consistent copy.
+template <typename T>
+class Mailbox
+{
+public:
+    Mailbox() : sequence(0), value{}
+    {
+    }
+
+    void post(const T &next)
+    {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed); // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        value = next;
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /// @brief Reads the latest value if it changed since lastSequence. Never waits for the producer:
+    /// a post in progress (the reader may have preempted it) or a copy torn READ_RETRIES times
+    /// returns false, and the caller keeps its last value until the next read.
+    /// @return True if out was updated
+    bool read(T &out, uint32_t &lastSequence) const
+    {
+        for (int attempt = 0; attempt < READ_RETRIES; attempt++)
+        {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before == lastSequence || (before & 1))
+                return false;
+
+            T copy = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                out = copy;
+                lastSequence = before;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    // a post completed during the copy, only possible with the producer on the other core
+    static constexpr int READ_RETRIES = 3;
+
+    std::atomic<uint32_t> sequence;
+    T value;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef _FIXED_H
+#define _FIXED_H
+
+#include <stdint.h>
+#include <compare>
+
+/// @brief Signed 32-bit fixed-point number with FractionBits fractional bits.
+/// The RP2040 has no FPU, so this keeps hot math in integer instructions.
+template <int FractionBits>
+class Fixed
+{
+    static_assert(FractionBits > 0 && FractionBits < 31, "Fixed needs at least one integer and one fraction bit");
+
+public:
+    static constexpr int FRACTION_BITS = FractionBits;
+    static constexpr int32_t ONE = (int32_t)1 << FractionBits;
+
+    constexpr Fixed() : value(0)
+    {
+    }
+
+    static constexpr Fixed fromRaw(int32_t raw)
+    {
+        Fixed f;
+        f.value = raw;
+        return f;
+    }
+
+    static constexpr Fixed fromInt(int32_t v)
+    {
+        return fromRaw(v * ONE);
+    }
+
+    /// @brief Rounds to nearest, out of range values saturate and NaN becomes zero
+    static constexpr Fixed fromFloat(float v)
+    {
+        float scaled = v * (float)ONE + (v >= 0 ? 0.5f : -0.5f);
+        if (scaled != scaled)
+            return fromRaw(0);
+        // 2^31, INT32_MAX is not representable as a float
+        if (scaled >= 2147483648.0f)
+            return fromRaw(INT32_MAX);
+        if (scaled <= -2147483648.0f)
+            return fromRaw(INT32_MIN);
+        return fromRaw((int32_t)scaled);
+    }
+
+    constexpr int32_t raw() const
+    {
+        return value;
+    }
+
+    constexpr float toFloat() const
+    {
+        return (float)value / (float)ONE;
+    }
+
+    constexpr int32_t toInt() const
+    {
+        return value >> FractionBits;
+    }
+
+    /// @brief Scales to an integer range, e.g. a PWM level: (this * range) rounded towards zero
+    constexpr int32_t scaleTo(int32_t range) const
+    {
+        return (int32_t)(((int64_t)value * range) / ONE);
+    }
+
+    constexpr Fixed abs() const
+    {
+        return fromRaw(value < 0 ? -value : value);
+    }
+
+    constexpr Fixed operator-() const
+    {
+        return fromRaw(-value);
+    }
+
+    constexpr Fixed operator+(Fixed other) const
+    {
+        return fromRaw(value + other.value);
+    }
+
+    constexpr Fixed operator-(Fixed other) const
+    {
+        return fromRaw(value - other.value);
+    }
+
+    constexpr Fixed operator*(Fixed other) const
+    {
+        return fromRaw((int32_t)(((int64_t)value * other.value) >> FractionBits));
+    }
+
+    constexpr Fixed operator/(Fixed other) const
+    {
+        return fromRaw((int32_t)(((int64_t)value * ONE) / other.value));
+    }
+
+    constexpr Fixed operator*(int32_t scalar) const
+    {
+        return fromRaw(value * scalar);
+    }
+
+    constexpr Fixed operator/(int32_t scalar) const
+    {
+        return fromRaw(value / scalar);
+    }
+
+    constexpr Fixed &operator+=(Fixed other)
+    {
+        value += other.value;
+        return *this;
+    }
+
+    constexpr Fixed &operator-=(Fixed other)
+    {
+        value -= other.value;
+        return *this;
+    }
+
+    constexpr Fixed &operator*=(Fixed other)
+    {
+        return *this = *this * other;
+    }
+
+    constexpr auto operator<=>(const Fixed &other) const = default;
+
+private:
+    int32_t value;
+};
+
+using q16_16 = Fixed<16>;
+
+template <int FractionBits>
+constexpr Fixed<FractionBits> clamp(Fixed<FractionBits> v, Fixed<FractionBits> lo, Fixed<FractionBits> hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _FIXED_TRIG_H
+#define _FIXED_TRIG_H
+
+#include "math/fixed.h"
+
+namespace FixedTrig
+{
+    template <int FractionBits>
+    constexpr Fixed<FractionBits> PI = Fixed<FractionBits>::fromFloat(3.14159265358979f);
+    template <int FractionBits>
+    constexpr Fixed<FractionBits> HALF_PI = Fixed<FractionBits>::fromFloat(1.57079632679490f);
+    template <int FractionBits>
+    constexpr Fixed<FractionBits> TWO_PI = Fixed<FractionBits>::fromFloat(6.28318530717959f);
+
+    /// @brief Wraps an angle into [-pi, pi)
+    template <int FractionBits>
+    constexpr Fixed<FractionBits> wrap(Fixed<FractionBits> angle)
+    {
+        while (angle >= PI<FractionBits>)
+            angle -= TWO_PI<FractionBits>;
+        while (angle < -PI<FractionBits>)
+            angle += TWO_PI<FractionBits>;
+        return angle;
+    }
+
+    /// @brief Sine using a 7th order Taylor series on [-pi/2, pi/2] (error below 2e-4 in Q16.16)
+    template <int FractionBits>
+    constexpr Fixed<FractionBits> sin(Fixed<FractionBits> angle)
+    {
+        angle = wrap(angle);
+        if (angle > HALF_PI<FractionBits>)
+            angle = PI<FractionBits> - angle;
+        else if (angle < -HALF_PI<FractionBits>)
+            angle = -PI<FractionBits> - angle;
+
+        Fixed<FractionBits> x2 = angle * angle;
+        // x * (1 - x^2/6 * (1 - x^2/20 * (1 - x^2/42)))
+        Fixed<FractionBits> one = Fixed<FractionBits>::fromInt(1);
+        Fixed<FractionBits> term = one - x2 / 42;
+        term = one - x2 * term / 20;
+        term = one - x2 * term / 6;
+        return angle * term;
+    }
+
+    template <int FractionBits>
+    constexpr Fixed<FractionBits> cos(Fixed<FractionBits> angle)
+    {
+        return sin(angle + HALF_PI<FractionBits>);
+    }
+}
+
+#endif
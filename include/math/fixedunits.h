@@ -0,0 +1,80 @@
+#ifndef _FIXED_UNITS_H
+#define _FIXED_UNITS_H
+
+#include <math/units.h>
+#include "math/fixed.h"
+
+/// @brief Fixed-point counterpart of Units<float>, stored in SI base units (meters, radians)
+template <int FractionBits>
+class FixedUnits
+{
+public:
+    using value_type = Fixed<FractionBits>;
+
+    constexpr FixedUnits() : value()
+    {
+    }
+
+    static constexpr FixedUnits meters(value_type v)
+    {
+        return FixedUnits(v);
+    }
+    static constexpr FixedUnits meters(float v)
+    {
+        return FixedUnits(value_type::fromFloat(v));
+    }
+    static constexpr FixedUnits inches(float v)
+    {
+        return FixedUnits(value_type::fromFloat(v * 0.0254f));
+    }
+    static constexpr FixedUnits radians(value_type v)
+    {
+        return FixedUnits(v);
+    }
+    static constexpr FixedUnits radians(float v)
+    {
+        return FixedUnits(value_type::fromFloat(v));
+    }
+    static constexpr FixedUnits degrees(float v)
+    {
+        return FixedUnits(value_type::fromFloat(v * 0.017453292519943295f));
+    }
+
+    static FixedUnits fromMeters(Units<float> units)
+    {
+        return meters(units.meters());
+    }
+    static FixedUnits fromRadians(Units<float> units)
+    {
+        return radians(units.radians());
+    }
+
+    constexpr value_type meters() const
+    {
+        return value;
+    }
+    constexpr value_type radians() const
+    {
+        return value;
+    }
+
+    Units<float> toMeters() const
+    {
+        return Units<float>::meters(value.toFloat());
+    }
+    Units<float> toRadians() const
+    {
+        return Units<float>::radians(value.toFloat());
+    }
+
+private:
+    constexpr explicit FixedUnits(value_type value) : value(value)
+    {
+    }
+
+    value_type value;
+};
+
+using FixedUnitsQ16 = FixedUnits<16>;
+
+#endif
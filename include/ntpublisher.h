@@ -0,0 +1,80 @@
+#ifndef _NT_PUBLISHER_H
+#define _NT_PUBLISHER_H
+
+#include <stdint.h>
+#include <initializer_list>
+#include <pico/stdlib.h>
+#include <pico/critical_section.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include <nt/ntinstance.h>
+#include <nt/ntentry.h>
+
+enum class NTPriority : uint8_t
+{
+    High,   // flushed as soon as it changes (coalesced to NT_MIN_FLUSH_INTERVAL_MS)
+    Normal, // at most every NT_NORMAL_PERIOD_MS
+    Low     // at most every NT_LOW_PERIOD_MS
+};
+
+struct NTPublisherStats
+{
+    uint32_t flushes;
+    uint32_t entriesSent;
+    uint32_t lastFlushUs;
+    uint32_t maxFlushUs;
+};
+
+/// @brief Owns NetworkTables serialization on its own task. Control code only copies
+/// floats into a staging slot, changed slots are batched into the next flush.
+class NTPublisher
+{
+    friend void nt_publisher_task(void *pv_publisher);
+
+public:
+    static constexpr int MAX_ENTRIES = 16;
+    static constexpr int MAX_VALUES = 6;
+
+    NTPublisher(NetworkTableInstance *nt);
+    ~NTPublisher();
+
+    /// @brief Creates a float array entry (call before publishing starts)
+    /// @return Handle for set, -1 if the table is full
+    int add(const char *name, int valueCount, NTPriority priority);
+
+    /// @brief Stages new values, marks the entry dirty only if they changed (any task, no allocation)
+    void set(int handle, std::initializer_list<float> values);
+
+    const NTPublisherStats &getStats()
+    {
+        return stats;
+    }
+
+private:
+    struct Slot
+    {
+        NTEntry *entry;
+        NTPriority priority;
+        uint8_t count;
+        bool dirty;
+        float values[MAX_VALUES];
+    };
+
+    void flush();
+
+    NetworkTableInstance *nt;
+
+    Slot slots[MAX_ENTRIES];
+    int slotCount;
+    critical_section_t lock;
+
+    TaskHandle_t task;
+    volatile bool running;
+    volatile bool exited;
+
+    uint64_t lastNormalUs;
+    uint64_t lastLowUs;
+    NTPublisherStats stats;
+};
+
+#endif
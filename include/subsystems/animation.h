@@ -0,0 +1,110 @@
+#ifndef _ANIMATION_H
+#define _ANIMATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+namespace Animation
+{
+    enum class Easing : uint8_t
+    {
+        Step,     // hold the level until the next keyframe
+        Linear,   // straight ramp to the next keyframe
+        EaseInOut // smoothstep ramp to the next keyframe
+    };
+
+    /// @brief A level reached at a time (us), and how to move on to the next keyframe
+    struct Keyframe
+    {
+        uint32_t time;
+        uint16_t level;
+        Easing easing;
+    };
+
+    /// @brief A looping sequence of keyframes. The last keyframe moves back to the first one at length.
+    struct Timeline
+    {
+        const Keyframe *keyframes;
+        size_t count;
+        uint32_t length;
+
+        template <size_t N>
+        constexpr Timeline(const Keyframe (&keyframes)[N], uint32_t length) : keyframes(keyframes), count(N), length(length)
+        {
+        }
+
+        constexpr bool isConstant() const
+        {
+            for (size_t i = 1; i < count; i++)
+                if (keyframes[i].level != keyframes[0].level)
+                    return false;
+            return true;
+        }
+
+        constexpr uint16_t levelAt(uint32_t time) const
+        {
+            time %= length;
+            size_t i = segment(time);
+            const Keyframe &from = keyframes[i];
+            const Keyframe &to = keyframes[(i + 1) % count];
+            uint32_t end = i + 1 < count ? to.time : length;
+
+            if (from.easing == Easing::Step || end <= from.time)
+                return from.level;
+
+            // progress through the segment in Q16
+            uint32_t t = (uint32_t)(((uint64_t)(time - from.time) << 16) / (end - from.time));
+            if (from.easing == Easing::EaseInOut)
+                t = (uint32_t)(((uint64_t)t * t * (3 * 65536 - 2 * (uint64_t)t)) >> 32);
+
+            return (uint16_t)(from.level + (((int64_t)to.level - from.level) * t >> 16));
+        }
+
+        /// @brief Time (us) the level stays unchanged from time on, or 0 if it is ramping
+        constexpr uint32_t holdTime(uint32_t time) const
+        {
+            time %= length;
+            size_t i = segment(time);
+            const Keyframe &from = keyframes[i];
+            const Keyframe &to = keyframes[(i + 1) % count];
+            uint32_t end = i + 1 < count ? to.time : length;
+
+            if (from.easing == Easing::Step || from.level == to.level)
+                return end - time;
+            return 0;
+        }
+
+    private:
+        constexpr size_t segment(uint32_t time) const
+        {
+            size_t i = 0;
+            while (i + 1 < count && keyframes[i + 1].time <= time)
+                i++;
+            return i;
+        }
+    };
+
+    /// @brief Maps the high byte of a level to a perceptually linear output level
+    template <int Exponent>
+    constexpr std::array<uint16_t, 256> makeGammaTable()
+    {
+        static_assert(Exponent >= 1 && Exponent <= 3, "Gamma exponent must keep 256^Exponent in 32 bits");
+
+        uint64_t max = 1;
+        for (int e = 0; e < Exponent; e++)
+            max *= 256;
+
+        std::array<uint16_t, 256> table{};
+        for (size_t i = 0; i < table.size(); i++)
+        {
+            uint64_t v = 1;
+            for (int e = 0; e < Exponent; e++)
+                v *= i + 1;
+            table[i] = (uint16_t)((v - 1) * 0xFFFF / (max - 1));
+        }
+        return table;
+    }
+}
+
+#endif
@@ -4,10 +4,14 @@
 #include <stdlib.h>
 #include <pico/stdlib.h>
 #include <pico/time.h>
+#include "math/fixed.h"
 
 class Battery
 {
 public:
+    static constexpr uint SAMPLE_BUFFER_BITS = 8;
+    static constexpr uint SAMPLE_BUFFER_LENGTH = 1 << SAMPLE_BUFFER_BITS;
+
     Battery();
     ~Battery();
 
@@ -16,16 +20,63 @@ public:
 
     void ping();
 
+    /// @brief Filters the latest ADC samples (written continuously by DMA), call periodically.
+    /// Does nothing while Config::Battery::ENABLED is off or before the sample ring has filled once.
+    void update();
+
+    /// @brief Pack voltage averaged over the last few milliseconds
+    float getVoltage()
+    {
+        return voltage;
+    }
+
+    /// @brief Drop of the live voltage below the slowly filtered resting voltage
+    float getSag()
+    {
+        return restingVoltage > voltage ? restingVoltage - voltage : 0.0f;
+    }
+
+    /// @brief The last reading was a plausible pack voltage, compensation and brownout follow it
+    bool isValid()
+    {
+        return valid;
+    }
+
+    bool isBrownout()
+    {
+        return brownout;
+    }
+
+    /// @brief Duty cycle scale (nominal / actual voltage) that keeps motor speed independent of charge
+    q16_16 getCompensation()
+    {
+        return compensation;
+    }
+
     uint getPingPin()
     {
         return pingPin;
     }
 
 private:
+    float readAverage(uint count);
+
     repeating_timer_t pingTimer;
     bool pingTimerRunning;
 
     uint pingPin;
+
+    uint sampleDma;
+    uint controlDma;
+    uint32_t sampleReload;
+
+    float voltage;
+    float restingVoltage;
+    bool valid;
+    bool brownout;
+    q16_16 compensation;
+    uint64_t lastUpdate;
+    uint64_t readyUs; // the DMA ring has been filled once
 };
 
-#endif
\ No newline at end of file
+#endif
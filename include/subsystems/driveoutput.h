@@ -0,0 +1,83 @@
+#ifndef _DRIVE_OUTPUT_H
+#define _DRIVE_OUTPUT_H
+
+#include <stdint.h>
+#include <pico/stdlib.h>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "math/fixed.h"
+#include "mailbox.h"
+#include "motoroutputs.h"
+
+class DifferentialModule;
+class Odometry;
+
+struct DriveTargets
+{
+    q16_16 left;  // m/s
+    q16_16 right; // m/s
+    bool immediate; // skip the acceleration limit (stop)
+};
+
+/// @brief High-rate motor output loop, pinned to the second core.
+/// Takes wheel speed targets through a lock-free mailbox and ramps the PWM outputs towards them.
+class DriveOutput
+{
+    friend void drive_output_task(void *pv_output);
+
+public:
+    DriveOutput(MotorOutputs *outputs, DifferentialModule *left, DifferentialModule *right, Odometry *odometry);
+    ~DriveOutput();
+
+    void setTargets(q16_16 left, q16_16 right);
+    void stop();
+
+    /// @brief One output period: read targets, ramp, commit, integrate odometry (called by the output task)
+    void update();
+
+    bool isRunning()
+    {
+        return running;
+    }
+
+    q16_16 getLeftOutput()
+    {
+        return leftOutput;
+    }
+    q16_16 getRightOutput()
+    {
+        return rightOutput;
+    }
+
+    /// @brief Completed output periods, watched by Failsafe::feed
+    uint32_t getTicks()
+    {
+        return ticks;
+    }
+
+private:
+    q16_16 ramp(q16_16 current, q16_16 target);
+
+    MotorOutputs *outputs;
+    DifferentialModule *left;
+    DifferentialModule *right;
+    Odometry *odometry;
+
+    TaskHandle_t task;
+    volatile bool running;
+    volatile bool exited;
+
+    Mailbox<DriveTargets> mailbox;
+    uint32_t mailboxSequence;
+    DriveTargets targets;
+
+    q16_16 leftOutput;
+    q16_16 rightOutput;
+
+    q16_16 accelerationStep; // per output period, from ConfigStore
+    q16_16 decelerationStep;
+
+    volatile uint32_t ticks;
+};
+
+#endif
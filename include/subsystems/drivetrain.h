@@ -1,24 +1,53 @@
 #ifndef _DRIVETRAIN_H
 #define _DRIVETRAIN_H
 
-#include <motor.h>
 #include <math/units.h>
 #include <kinematics/differentialdrive.h>
+#include "math/fixedunits.h"
+#include "kinematics/fixeddifferentialdrive.h"
 #include "moduleconfig.h"
+#include "control/velocitysensor.h"
+#include "control/velocitycontroller.h"
+#include "motoroutputs.h"
+#include "driveoutput.h"
+#include "odometry.h"
 
 class DifferentialModule
 {
 public:
-    DifferentialModule(const ModuleConfig &config);
+    DifferentialModule(const ModuleConfig &config, MotorOutputs *outputs, MotorIndex front, MotorIndex center, MotorIndex back);
     ~DifferentialModule();
 
+    /// @brief Stages the module speed, applied on the next MotorOutputs::commit (DriveOutput task only)
     void setDesiredState(Units<float> speed);
+    void setDesiredState(q16_16 speed);
     void stop();
 
+    /// @brief Replaces the velocity feedback source (nullptr for feedforward only), takes ownership
+    void setVelocitySensor(VelocitySensor *sensor);
+
+    q16_16 getVelocityError()
+    {
+        return controller.getError();
+    }
+
+    /// @brief Measured wheel speed if the module has feedback, otherwise the last setpoint
+    q16_16 getVelocity()
+    {
+        return velocity;
+    }
+
 private:
-    Motor *motorFront;
-    Motor *motorCenter;
-    Motor *motorBack;
+    void stage(q16_16 duty);
+
+    MotorOutputs *outputs;
+    MotorIndex motorFront;
+    MotorIndex motorCenter;
+    MotorIndex motorBack;
+
+    VelocityController controller;
+    VelocitySensor *sensor;
+    q16_16 velocity;
 
     Units<float> wheelDiameter;
 };
@@ -30,13 +59,76 @@ public:
     ~Drivetrain();
 
     void drive(Units<float> speed, Units<float> rotation);
+    void drive(FixedUnitsQ16 speed, FixedUnitsQ16 rotation);
     void stop();
 
+    /// @brief While held every drive call stops instead (config flash writes)
+    void setHold(bool hold)
+    {
+        held = hold;
+    }
+    /// @brief True if the targets and the ramped outputs are all zero
+    bool isStopped()
+    {
+        return leftTarget.raw() == 0 && rightTarget.raw() == 0 && getLeftOutput().raw() == 0 && getRightOutput().raw() == 0;
+    }
+
+    /// @brief Duty cycle scale applied to every motor, see Battery::getCompensation
+    void setVoltageCompensation(q16_16 scale)
+    {
+        outputs->setVoltageCompensation(scale);
+    }
+
+    Odometry *getOdometry()
+    {
+        return odometry;
+    }
+
+    MotorOutputs *getOutputs()
+    {
+        return outputs;
+    }
+
+    DriveOutput *getDriveOutput()
+    {
+        return output;
+    }
+
+    /// @brief Wheel speed targets of the last drive/stop call (m/s)
+    q16_16 getLeftTarget()
+    {
+        return leftTarget;
+    }
+    q16_16 getRightTarget()
+    {
+        return rightTarget;
+    }
+
+    /// @brief Ramped wheel speeds currently applied by the output task (m/s)
+    q16_16 getLeftOutput()
+    {
+        return output->getLeftOutput();
+    }
+    q16_16 getRightOutput()
+    {
+        return output->getRightOutput();
+    }
+
 private:
     DifferentialDriveKinematics *kinematics;
+    FixedDifferentialDriveKinematics<16> fixedKinematics;
+    Units<float> maxSpeed; // m/s, from ConfigStore
+    q16_16 maxSpeedFixed;
 
+    MotorOutputs *outputs;
     DifferentialModule *left;
     DifferentialModule *right;
+    Odometry *odometry;
+    DriveOutput *output;
+
+    q16_16 leftTarget;
+    q16_16 rightTarget;
+    volatile bool held;
 };
 
-#endif
\ No newline at end of file
+#endif
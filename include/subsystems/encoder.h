@@ -0,0 +1,43 @@
+#ifndef _ENCODER_H
+#define _ENCODER_H
+
+#include <stdint.h>
+#include <pico/stdlib.h>
+#include <math/units.h>
+#include "math/fixed.h"
+#include "control/velocitysensor.h"
+
+/// @brief Interrupt driven quadrature encoder, velocity averaged over the last ENCODER_WINDOW reads
+class QuadratureEncoder : public VelocitySensor
+{
+public:
+    static constexpr uint ENCODER_WINDOW = 10;
+
+    QuadratureEncoder(uint pinA, uint pinB, uint countsPerRevolution, Units<float> wheelDiameter, float readPeriod);
+    ~QuadratureEncoder();
+
+    bool read(q16_16 &velocity) override;
+
+    int32_t getCount()
+    {
+        return count;
+    }
+
+private:
+    static void irq_handler();
+    void handleEdge();
+
+    uint pinA;
+    uint pinB;
+
+    volatile int32_t count;
+    uint8_t state;
+
+    q16_16 velocityPerCount; // m/s for one count across the whole window
+    int32_t window[ENCODER_WINDOW];
+    uint windowIndex;
+    int32_t windowSum;
+    int32_t lastCount;
+};
+
+#endif
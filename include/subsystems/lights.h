@@ -3,8 +3,10 @@
 
 #include <stdlib.h>
 #include <pico/stdlib.h>
+#include <hardware/pio.h>
 #include <FreeRTOS.h>
 #include <task.h>
+#include <semphr.h>
 
 enum class Pattern
 {
@@ -22,6 +24,7 @@ public:
     Lights();
     ~Lights();
 
+    /// @brief Switches the ring indicator waveforms (played back by PIO/DMA, no CPU afterwards), any task
     void setRingIndicatorPattern(Pattern left, Pattern right);
     void setStatusLedPattern(Pattern pattern);
 
@@ -54,16 +57,28 @@ public:
     }
 
 private:
+    void startRingIndicators();
+    void stopRingIndicators();
+
     TaskHandle_t animationTask;
     bool animationRunning;
 
+    SemaphoreHandle_t ringMutex; // ring patterns and the PIO/DMA restart
+
     uint leftRingIndicatorPin;
     uint rightRingIndicatorPin;
 
+    PIO pio;
+    uint pioOffset;
+    uint leftSm;
+    uint rightSm;
+    uint leftDma;
+    uint rightDma;
+
     Pattern leftRingIndicatorPattern;
     Pattern rightRingIndicatorPattern;
 
     Pattern statusLedPattern;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -8,6 +8,8 @@
 
 struct ModuleConfig
 {
+    static constexpr uint NO_ENCODER = 0xFFFFFFFF;
+
     uint frontPinCW;
     uint frontPinCCW;
     uint centerPinCW;
@@ -17,21 +19,37 @@ struct ModuleConfig
 
     Units<float> wheelDiameter;
 
+    // optional quadrature encoder for closed loop velocity control
+    uint encoderPinA;
+    uint encoderPinB;
+    uint encoderCountsPerRevolution;
+
     constexpr ModuleConfig(uint frontPinCW,
                            uint frontPinCCW,
                            uint centerPinCW,
                            uint centerPinCCW,
                            uint backPinCW,
                            uint backPinCCW,
-                           Units<float> wheelDiameter) : frontPinCW(frontPinCW),
-                                                         frontPinCCW(frontPinCCW),
-                                                         centerPinCW(centerPinCW),
-                                                         centerPinCCW(centerPinCCW),
-                                                         backPinCW(backPinCW),
-                                                         backPinCCW(backPinCCW),
-                                                         wheelDiameter(wheelDiameter)
+                           Units<float> wheelDiameter,
+                           uint encoderPinA = NO_ENCODER,
+                           uint encoderPinB = NO_ENCODER,
+                           uint encoderCountsPerRevolution = 0) : frontPinCW(frontPinCW),
+                                                                  frontPinCCW(frontPinCCW),
+                                                                  centerPinCW(centerPinCW),
+                                                                  centerPinCCW(centerPinCCW),
+                                                                  backPinCW(backPinCW),
+                                                                  backPinCCW(backPinCCW),
+                                                                  wheelDiameter(wheelDiameter),
+                                                                  encoderPinA(encoderPinA),
+                                                                  encoderPinB(encoderPinB),
+                                                                  encoderCountsPerRevolution(encoderCountsPerRevolution)
+    {
+    }
+
+    constexpr bool hasEncoder() const
     {
+        return encoderPinA != NO_ENCODER && encoderPinB != NO_ENCODER && encoderCountsPerRevolution > 0;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
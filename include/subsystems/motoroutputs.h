@@ -0,0 +1,74 @@
+#ifndef _MOTOR_OUTPUTS_H
+#define _MOTOR_OUTPUTS_H
+
+#include <stdint.h>
+#include <pico/stdlib.h>
+#include <hardware/pwm.h>
+#include "math/fixed.h"
+#include "moduleconfig.h"
+
+enum class MotorIndex : uint
+{
+    LeftFront,
+    LeftCenter,
+    LeftBack,
+    RightFront,
+    RightCenter,
+    RightBack
+};
+
+/// @brief Batched PWM output stage for all drive motors.
+/// Duty cycles are staged in RAM and committed with one compare register write per slice,
+/// so every wheel changes speed in the same PWM period.
+class MotorOutputs
+{
+public:
+    static constexpr uint MOTOR_COUNT = 6;
+
+    MotorOutputs(const ModuleConfig &left, const ModuleConfig &right);
+    ~MotorOutputs();
+
+    /// @brief Stages a signed duty cycle in [-1, 1] without touching the hardware
+    void stage(MotorIndex motor, q16_16 duty);
+    /// @brief Latches all staged duty cycles into the PWM slices at once (no-op if nothing changed)
+    void commit();
+    void stop();
+
+    /// @brief Takes every motor pin off the PWM and drives it low right away, without waiting for
+    /// a period wrap. Interrupt safe, for the failsafe; the outputs stay off until the next reset.
+    void forceStop();
+
+    /// @brief Scales every staged duty cycle, e.g. by nominal / battery voltage
+    void setVoltageCompensation(q16_16 scale)
+    {
+        compensation = scale;
+    }
+
+    uint32_t getCommitCount()
+    {
+        return commitCount;
+    }
+
+private:
+    struct Output
+    {
+        uint pinCW;
+        uint pinCCW;
+    };
+
+    void setPinLevel(uint pin, uint16_t level);
+
+    Output outputs[MOTOR_COUNT];
+
+    uint16_t levels[NUM_PWM_SLICES][2]; // staged compare levels per slice channel
+    uint8_t channelMask[NUM_PWM_SLICES]; // channels driven by motors
+    uint32_t sliceMask;
+    uint referenceSlice;
+
+    q16_16 compensation;
+
+    bool dirty;
+    uint32_t commitCount;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef _ODOMETRY_H
+#define _ODOMETRY_H
+
+#include <stdint.h>
+#include <pico/stdlib.h>
+#include <pico/critical_section.h>
+#include "math/fixed.h"
+#include "kinematics/fixeddifferentialdrive.h"
+
+struct Pose
+{
+    q16_16 x;       // m, forward at boot
+    q16_16 y;       // m, left at boot
+    q16_16 heading; // rad, counter-clockwise, [-pi, pi)
+};
+
+struct TimestampedPose
+{
+    uint64_t timeUs;
+    Pose pose;
+};
+
+/// @brief Integrates wheel speeds into a pose at the drive output rate and keeps a
+/// timestamped history for latency compensated lookups.
+class Odometry
+{
+public:
+    static constexpr uint HISTORY_SIZE = 256;
+
+    Odometry(const FixedDifferentialDriveKinematics<16> &kinematics);
+
+    /// @brief Integrates one step (drive output task only)
+    void update(q16_16 leftSpeed, q16_16 rightSpeed, uint64_t timeUs);
+
+    TimestampedPose getPose();
+    /// @brief Pose at a past time, interpolated from the history in O(log n)
+    /// @return False if timeUs is older than the history or no history exists yet
+    bool getPoseAt(uint64_t timeUs, Pose &out);
+
+    q16_16 getForwardSpeed()
+    {
+        return forwardSpeed;
+    }
+    q16_16 getAngularSpeed()
+    {
+        return angularSpeed;
+    }
+
+private:
+    void record(const TimestampedPose &sample);
+    const TimestampedPose &historyAt(uint index);
+
+    FixedDifferentialDriveKinematics<16> kinematics;
+    critical_section_t lock;
+
+    TimestampedPose current;
+    // Q32.32 accumulators, a single 1 ms step is too small for Q16.16
+    int64_t x;
+    int64_t y;
+    int64_t heading;
+    uint64_t lastUpdateUs;
+    uint64_t lastRecordUs;
+
+    q16_16 forwardSpeed;
+    q16_16 angularSpeed;
+
+    TimestampedPose history[HISTORY_SIZE];
+    uint historyStart; // oldest sample
+    uint historyCount;
+};
+
+#endif
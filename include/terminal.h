@@ -1,5 +1,45 @@
+#ifndef _TERMINAL_H
+#define _TERMINAL_H
+
 namespace Terminal
 {
+    static constexpr int MAX_COMMANDS = 32;
+    static constexpr int MAX_TUNABLES = 16;
+    static constexpr int MAX_ARGS = 8;
+    static constexpr int LINE_LENGTH = 128;
+
+    /// @brief Command handler, argv[0] is the command name. Runs on the terminal task.
+    typedef void (*CommandHandler)(int argc, char **argv, void *context);
+
+    struct Command
+    {
+        const char *name;
+        const char *usage; // arguments, e.g. "<name> <value>"
+        const char *help;
+        CommandHandler handler;
+        void *context;
+    };
+
+    enum class TunableType
+    {
+        Float,
+        Fixed // q16_16
+    };
+
+    /// @brief A live variable readable and writable with get/set
+    struct Tunable
+    {
+        const char *name;
+        TunableType type;
+        void *value;
+    };
+
     void start();
     void stop();
-}
\ No newline at end of file
+
+    /// @brief Adds a command to the dispatch table (strings must outlive the terminal)
+    bool registerCommand(const Command &command);
+    bool registerTunable(const Tunable &tunable);
+}
+
+#endif
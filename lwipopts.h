@@ -1,6 +1,14 @@
 #ifndef _LWIPOPTS_H
 #define _LWIPOPTS_H
 
+// Build profile (ROVER_PROFILE in CMakeLists.txt, debug for a Debug build and release otherwise):
+//   debug   - lwIP debug output and statistics
+//   capture - statistics without debug output, for sizing the pools under a real session
+//   release - no debug output or statistics
+#if !defined(ROVER_PROFILE_RELEASE) && !defined(ROVER_PROFILE_CAPTURE)
+#define ROVER_PROFILE_DEBUG 1
+#endif
+
 #define NO_SYS 0
 
 #define LWIP_SOCKET 1
@@ -22,6 +30,8 @@
 #define DEFAULT_ACCEPTMBOX_SIZE TCPIP_MBOX_SIZE
 
 #define MEM_ALIGNMENT 4
+// Pool sizes are shared by all profiles so a capture build measures the pools a release build runs
+// with. Update them from "lwip sizing" after "lwip capture" and a driving session on a capture build.
 #define MEM_SIZE 4000
 #define MEMP_NUM_TCP_SEG 128
 #define MEMP_NUM_ARP_QUEUE 30
@@ -39,11 +49,10 @@
 #define LWIP_NETIF_STATUS_CALLBACK 1
 #define LWIP_NETIF_LINK_CALLBACK 1
 #define LWIP_NETIF_HOSTNAME 1
+#ifndef ROVER_PROFILE_RELEASE
+#define LWIP_NETIF_LOOPBACK 1 // datagrams to our own address, used by the udp latency diagnostic
+#endif
 #define LWIP_NETCONN 0
-#define MEM_STATS 1
-#define SYS_STATS 0
-#define MEMP_STATS 1
-#define LINK_STATS 0
 // #define ETH_PAD_SIZE 2
 #define LWIP_CHKSUM_ALGORITHM 3
 #define LWIP_CHECKSUM_ON_COPY 1
@@ -58,12 +67,21 @@
 #define LWIP_DHCP_DOES_ACD_CHECK 0
 
 #define SO_REUSE 1
+#define TCP_LISTEN_BACKLOG 1
 
-#ifndef NDEBUG
+#ifdef ROVER_PROFILE_DEBUG
 #define LWIP_DEBUG 1
-#define LWIP_STATS 1
 #define LWIP_STATS_DISPLAY 1
-#define TCP_LISTEN_BACKLOG 1
+#endif
+
+#ifdef ROVER_PROFILE_RELEASE
+#define LWIP_STATS 0
+#else
+#define LWIP_STATS 1
+#define MEM_STATS 1
+#define SYS_STATS 0
+#define MEMP_STATS 1
+#define LINK_STATS 0
 #endif
 
 #include <stdint.h>
@@ -79,10 +97,22 @@
 #define IP_DEBUG LWIP_DBG_OFF
 #define IP_REASS_DEBUG LWIP_DBG_OFF
 #define RAW_DEBUG LWIP_DBG_OFF
+#ifdef ROVER_PROFILE_DEBUG
 #define MEM_DEBUG LWIP_DBG_ON
+#else
+#define MEM_DEBUG LWIP_DBG_OFF
+#endif
+#ifdef ROVER_PROFILE_DEBUG
 #define MEMP_DEBUG LWIP_DBG_ON
+#else
+#define MEMP_DEBUG LWIP_DBG_OFF
+#endif
 #define SYS_DEBUG LWIP_DBG_OFF
+#ifdef ROVER_PROFILE_DEBUG
 #define TCP_DEBUG LWIP_DBG_ON
+#else
+#define TCP_DEBUG LWIP_DBG_OFF
+#endif
 #define TCP_INPUT_DEBUG LWIP_DBG_OFF
 #define TCP_OUTPUT_DEBUG LWIP_DBG_OFF
 #define TCP_RTO_DEBUG LWIP_DBG_OFF
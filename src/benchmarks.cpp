@@ -0,0 +1,135 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/time.h>
+#include <hardware/clocks.h>
+
+// Libraries
+#include <math/units.h>
+#include <kinematics/differentialdrive.h>
+#include <packets/control/xbox.h>
+#include <msgpack/msgpack.hpp>
+
+// Config headers
+#include "config/options.h"
+
+#include "math/fixedunits.h"
+#include "kinematics/fixeddifferentialdrive.h"
+#include "subsystems/animation.h"
+#include "control/driverstation.h"
+#include "communication.h"
+#include "diagnostics.h"
+
+static constexpr uint32_t BENCH_ITERATIONS = 2000;
+static constexpr uint32_t BENCH_SLOW_ITERATIONS = 200; // heap allocating cases
+
+using Animation::Easing;
+using Animation::Keyframe;
+using Animation::Timeline;
+
+// same shape as the status LED pulse, with an eased segment so every levelAt branch runs
+static constexpr Keyframe BENCH_KEYFRAMES[] = {{0, 0, Easing::EaseInOut},
+                                               {250000, 0xFFFF, Easing::Linear},
+                                               {500000, 0x8000, Easing::Step}};
+static constexpr Timeline BENCH_TIMELINE(BENCH_KEYFRAMES, 1000000);
+
+/// @brief Times iterations of body and prints one JSON line. bytes is the data handled per call, 0 if none.
+template <class F>
+static void run_bench(const char *name, uint32_t iterations, size_t bytes, F &&body)
+{
+    // one untimed call to fault in the code and any lazily created state
+    body(0);
+
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < iterations; i++)
+        body(i);
+    uint64_t elapsedUs = time_us_64() - start;
+
+    uint32_t cyclesPerUs = clock_get_hz(clk_sys) / 1000000;
+    printf("{\"bench\":\"%s\",\"iterations\":%lu,\"total_us\":%llu,\"ns_per_op\":%.1f,\"cycles_per_op\":%lu,\"bytes\":%u}\n",
+           name, (unsigned long)iterations, (unsigned long long)elapsedUs,
+           (double)elapsedUs * 1000.0 / iterations,
+           (unsigned long)(elapsedUs * cyclesPerUs / iterations),
+           (unsigned)bytes);
+}
+
+void Diagnostics::benchmarkReport()
+{
+    // inputs read and results written through volatiles so the loops are not folded away
+    volatile float floatInput = 0.7f;
+    volatile float floatRotation = 3.3f;
+    volatile int32_t fixedInput = q16_16::fromFloat(0.7f).raw();
+    volatile int32_t fixedRotation = q16_16::fromFloat(3.3f).raw();
+    volatile uint32_t sink = 0;
+
+    CommunicationStatus status = {0x00010203, true};
+    CommunicationDistanceSensors sensors = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+    uint8_t commBuffer[Communication_DataSize];
+    Communication::pack(status, sensors, commBuffer);
+
+    run_bench("comm.pack", BENCH_ITERATIONS, Communication_DataSize, [&](uint32_t i)
+              {
+                  status.version = i;
+                  Communication::pack(status, sensors, commBuffer);
+                  sink = commBuffer[0]; });
+
+    run_bench("comm.unpack", BENCH_ITERATIONS, Communication_DataSize, [&](uint32_t i)
+              {
+                  commBuffer[0] = (uint8_t)i;
+                  CommunicationStatus outStatus;
+                  CommunicationDistanceSensors outSensors;
+                  Communication::unpack(commBuffer, &outStatus, &outSensors);
+                  sink = outStatus.version; });
+
+    // Drivetrain::drive without the output stage, float and fixed paths
+    DifferentialDriveKinematics floatKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE);
+    FixedDifferentialDriveKinematics<16> fixedKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE_FIXED);
+
+    run_bench("drive.float", BENCH_ITERATIONS, 0, [&](uint32_t)
+              {
+                  DifferentialDriveWheelSpeeds speeds = floatKinematics.toWheelSpeeds(ChassisSpeeds<float>(Units<float>::meters(floatInput), Units<float>::meters(0), Units<float>::radians(floatRotation)));
+                  speeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED);
+                  sink = (uint32_t)q16_16::fromFloat(speeds.left.meters()).raw(); });
+
+    run_bench("drive.fixed", BENCH_ITERATIONS, 0, [&](uint32_t)
+              {
+                  FixedDifferentialDriveWheelSpeeds<16> speeds = fixedKinematics.toWheelSpeeds({q16_16::fromRaw(fixedInput), q16_16(), q16_16::fromRaw(fixedRotation)});
+                  speeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED_FIXED.meters());
+                  sink = (uint32_t)speeds.left.raw(); });
+
+    run_bench("lights.level", BENCH_ITERATIONS, 0, [&](uint32_t i)
+              { sink = BENCH_TIMELINE.levelAt(i * 997); });
+
+    size_t propertiesSize = msgpack::pack(Config::ROBOT_PROPERTIES).size();
+    run_bench("ds.robot_properties", BENCH_SLOW_ITERATIONS, propertiesSize, [&](uint32_t)
+              {
+                  std::vector<uint8_t> data = msgpack::pack(Config::ROBOT_PROPERTIES);
+                  sink = data.size(); });
+
+    // the Driverstation ClockSync turnaround: unpack the request, pack the response
+    ClockSyncRequestPacket request = {123456789};
+    std::vector<uint8_t> requestData = msgpack::pack(request);
+    ClockSyncPacket clockSyncSample = {request.clientTime, time_us_64()};
+    size_t clockSyncSize = requestData.size() + msgpack::pack(clockSyncSample).size();
+    run_bench("ds.clock_sync", BENCH_SLOW_ITERATIONS, clockSyncSize, [&](uint32_t)
+              {
+                  std::error_code ec{};
+                  auto packet = msgpack::unpack<ClockSyncRequestPacket>(requestData.data(), requestData.size(), ec);
+                  ClockSyncPacket response = {packet.clientTime, get_absolute_time()};
+                  std::vector<uint8_t> data = msgpack::pack(response);
+                  sink = data.size(); });
+
+    // a neutral (all zero) input report, sized well past the packet
+    uint8_t xboxPacket[64] = {};
+    Control::Xbox xbox = {};
+    size_t xboxSize = (size_t)xbox.deserialize(xboxPacket, sizeof(xboxPacket));
+    run_bench("xbox.deserialize", BENCH_ITERATIONS, xboxSize, [&](uint32_t)
+              { sink = (uint32_t)xbox.deserialize(xboxPacket, sizeof(xboxPacket)); });
+
+    (void)sink;
+}
@@ -0,0 +1,96 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+
+#include "bootprofile.h"
+#include "terminal.h"
+
+struct StageTiming
+{
+    volatile uint32_t startUs;
+    volatile uint32_t endUs; // 0 while running or never started
+    volatile uint8_t core;
+    volatile bool started;
+};
+
+static const char *STAGE_NAMES[] = {"startup", "battery", "lights", "services", "drivetrain", "control", "communication",
+                                    "radio", "networktables", "driverstation", "xbox", "telemetry"};
+static const char *MILESTONE_NAMES[] = {"drive ready", "network ready", "first command"};
+
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == (int)BootProfile::Stage::Count, "Stage names out of sync");
+static_assert(sizeof(MILESTONE_NAMES) / sizeof(MILESTONE_NAMES[0]) == (int)BootProfile::Milestone::Count, "Milestone names out of sync");
+
+static StageTiming stages[(int)BootProfile::Stage::Count];
+static volatile uint32_t milestones[(int)BootProfile::Milestone::Count]; // 0 until reached
+
+static void boot_command(int argc, char **argv, void *context)
+{
+    BootProfile::print();
+}
+
+void BootProfile::init()
+{
+    Terminal::registerCommand({"boot", "", "Boot stage timings and milestones since reset", boot_command, nullptr});
+}
+
+void BootProfile::begin(Stage stage)
+{
+    StageTiming &timing = stages[(int)stage];
+    timing.startUs = (uint32_t)time_us_64();
+    timing.endUs = 0;
+    timing.core = (uint8_t)get_core_num();
+    timing.started = true;
+}
+
+void BootProfile::end(Stage stage)
+{
+    // never 0, that marks a stage still running
+    uint32_t now = (uint32_t)time_us_64();
+    stages[(int)stage].endUs = now > 0 ? now : 1;
+}
+
+void BootProfile::reached(Milestone milestone)
+{
+    if (milestones[(int)milestone] != 0)
+        return;
+
+    uint32_t now = (uint32_t)time_us_64();
+    milestones[(int)milestone] = now > 0 ? now : 1;
+}
+
+bool BootProfile::hasReached(Milestone milestone)
+{
+    return milestones[(int)milestone] != 0;
+}
+
+uint32_t BootProfile::getMilestoneUs(Milestone milestone)
+{
+    return milestones[(int)milestone];
+}
+
+void BootProfile::print()
+{
+    printf("%-14s %10s %10s Core\n", "Stage", "Start us", "Took us");
+    for (int i = 0; i < (int)Stage::Count; i++)
+    {
+        const StageTiming &timing = stages[i];
+        if (!timing.started)
+            printf("%-14s %10s\n", STAGE_NAMES[i], "-");
+        else if (timing.endUs == 0)
+            printf("%-14s %10lu %10s %4u\n", STAGE_NAMES[i], (unsigned long)timing.startUs, "running", (unsigned)timing.core);
+        else
+            printf("%-14s %10lu %10lu %4u\n", STAGE_NAMES[i], (unsigned long)timing.startUs, (unsigned long)(timing.endUs - timing.startUs),
+                   (unsigned)timing.core);
+    }
+
+    for (int i = 0; i < (int)Milestone::Count; i++)
+    {
+        if (milestones[i] != 0)
+            printf("%-14s at %lu us\n", MILESTONE_NAMES[i], (unsigned long)milestones[i]);
+        else
+            printf("%-14s not reached\n", MILESTONE_NAMES[i]);
+    }
+}
@@ -0,0 +1,102 @@
+// Standard headers
+#include <stdlib.h>
+#include <math.h>
+
+// Libraries
+#include <math/units.h>
+#include <kinematics/differentialdrive.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "math/fixedunits.h"
+#include "kinematics/fixeddifferentialdrive.h"
+#include "control/velocitycontroller.h"
+#include "control/simulatedmotor.h"
+#include "checks.h"
+
+static constexpr int KINEMATICS_SWEEP_STEPS = 41;
+
+// sagging pack and a loaded wheel, where feedforward alone falls short
+static constexpr SimulatedMotorParameters VELOCITY_PLANT = {
+    1.1f,  // freeSpeed
+    0.08f, // timeConstant
+    0.05f, // frictionDuty
+    0.85f, // supplyRatio
+    0.05f  // loadSpeedDrop
+};
+
+static float sweep_forward(int i)
+{
+    return -1.0f + 2.0f * (float)i / (float)(KINEMATICS_SWEEP_STEPS - 1);
+}
+
+static float sweep_rotation(int i)
+{
+    return -10.0f + 20.0f * (float)i / (float)(KINEMATICS_SWEEP_STEPS - 1);
+}
+
+static int32_t error_lsb(float expected, q16_16 actual)
+{
+    return abs(q16_16::fromFloat(expected).raw() - actual.raw());
+}
+
+Checks::KinematicsResult Checks::kinematics()
+{
+    DifferentialDriveKinematics floatKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE);
+    FixedDifferentialDriveKinematics<16> fixedKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE_FIXED);
+
+    int32_t maxError = 0;
+    for (int f = 0; f < KINEMATICS_SWEEP_STEPS; f++)
+    {
+        for (int r = 0; r < KINEMATICS_SWEEP_STEPS; r++)
+        {
+            DifferentialDriveWheelSpeeds floatSpeeds = floatKinematics.toWheelSpeeds(ChassisSpeeds<float>(Units<float>::meters(sweep_forward(f)), Units<float>::meters(0), Units<float>::radians(sweep_rotation(r))));
+            floatSpeeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED);
+
+            FixedDifferentialDriveWheelSpeeds<16> fixedSpeeds = fixedKinematics.toWheelSpeeds({q16_16::fromFloat(sweep_forward(f)), q16_16(), q16_16::fromFloat(sweep_rotation(r))});
+            fixedSpeeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED_FIXED.meters());
+
+            int32_t error = error_lsb(floatSpeeds.left.meters(), fixedSpeeds.left);
+            maxError = error > maxError ? error : maxError;
+            error = error_lsb(floatSpeeds.right.meters(), fixedSpeeds.right);
+            maxError = error > maxError ? error : maxError;
+        }
+    }
+
+    return {maxError, KINEMATICS_SWEEP_STEPS * KINEMATICS_SWEEP_STEPS, maxError <= KINEMATICS_MAX_ERROR_LSB};
+}
+
+Checks::StepResponse Checks::velocityStep(bool closedLoop)
+{
+    VelocityController controller(Config::Drivetrain::VELOCITY_GAINS, Config::Drivetrain::OUTPUT_PERIOD_FIXED);
+    SimulatedMotor motor(VELOCITY_PLANT);
+
+    float dt = Config::Drivetrain::OUTPUT_PERIOD_MS / 1000.0f;
+    int steps = (int)(VELOCITY_SIM_SECONDS / dt);
+    q16_16 setpoint = q16_16::fromFloat(VELOCITY_SETPOINT);
+
+    float riseTime = -1.0f;
+    float peak = 0.0f;
+    for (int i = 0; i < steps; i++)
+    {
+        q16_16 measured;
+        motor.read(measured);
+        q16_16 duty = closedLoop ? controller.calculate(setpoint, measured) : controller.calculate(setpoint);
+        motor.step(duty, dt);
+
+        float v = motor.getVelocity();
+        peak = fmaxf(peak, v);
+        if (riseTime < 0.0f && v >= 0.9f * VELOCITY_SETPOINT)
+            riseTime = (i + 1) * dt;
+    }
+
+    StepResponse response;
+    response.finalVelocity = motor.getVelocity();
+    response.error = VELOCITY_SETPOINT - response.finalVelocity;
+    response.riseTime = riseTime;
+    response.overshoot = fmaxf(0.0f, peak - VELOCITY_SETPOINT) / VELOCITY_SETPOINT;
+    response.pass = closedLoop && fabsf(response.error) <= VELOCITY_MAX_ERROR && riseTime >= 0.0f && riseTime <= VELOCITY_MAX_RISE_TIME &&
+                    response.overshoot <= VELOCITY_MAX_OVERSHOOT;
+    return response;
+}
@@ -2,8 +2,10 @@
 #include <pico/stdlib.h>
 #include <hardware/spi.h>
 #include <cstring>
+#include <algorithm>
 
 #include "communication.h"
+#include "inputcapture.h"
 
 static constexpr uint COMM_SPI_SCK = 2;
 static constexpr uint COMM_SPI_TX_MAIN = 3;
@@ -14,7 +16,7 @@ static constexpr uint COMM_SPI_CSN = 5;
 
 static constexpr uint COMM_SPI_BAUDRATE = 1 * 1000 * 1000;
 
-Communication::Communication(bool isMain) : isMain(isMain)
+Communication::Communication(bool isMain) : stats({}), replayBuffer{}, replaySequence(0), isMain(isMain)
 {
     baudrate = spi_init(spi0, COMM_SPI_BAUDRATE);
     spi_set_slave(spi0, !isMain);
@@ -23,10 +25,25 @@ Communication::Communication(bool isMain) : isMain(isMain)
     gpio_set_function(COMM_SPI_TX_MAIN, GPIO_FUNC_SPI); /* MAIN <--> SENSE, same function */
     gpio_set_function(COMM_SPI_RX_MAIN, GPIO_FUNC_SPI); /* MAIN <--> SENSE, same function */
     gpio_set_function(COMM_SPI_CSN, GPIO_FUNC_SPI);
+
+    if (isMain)
+    {
+        InputCapture::setReplayHandler(InputCapture::Source::Spi, [](const uint8_t *data, size_t length, void *context)
+                                       {
+                                           if (length != Communication_DataSize)
+                                               return;
+
+                                           std::array<uint8_t, Communication_DataSize> frame;
+                                           std::copy(data, data + Communication_DataSize, frame.begin());
+                                           ((Communication *)context)->replayFrame.post(frame); }, this);
+    }
 }
 
 Communication::~Communication()
 {
+    if (isMain)
+        InputCapture::setReplayHandler(InputCapture::Source::Spi, nullptr, nullptr);
+
     spi_deinit(spi0);
     gpio_deinit(COMM_SPI_SCK);
     gpio_deinit(COMM_SPI_TX_MAIN); /* MAIN <--> SENSE, same function */
@@ -39,19 +56,39 @@ bool Communication::hasData()
     return spi_is_readable(spi0);
 }
 
-bool Communication::read(const CommunicationControl &control, CommunicationStatus *out_status, CommunicationDistanceSensors *out_sensors)
+bool Communication::transfer(const uint8_t *out, uint8_t *in)
 {
-    uint8_t controlBuf[Communication_DataSize];
+    uint64_t start = time_us_64();
+    bool success = spi_write_read_blocking(spi0, out, in, Communication_DataSize) == Communication_DataSize;
 
-    controlBuf[0] = (uint8_t)control.command;
-    std::memcpy(&controlBuf[1], control.data, Communication_DataSize - 1);
+    stats.lastTransferUs = (uint32_t)(time_us_64() - start);
+    if (stats.lastTransferUs > stats.maxTransferUs)
+        stats.maxTransferUs = stats.lastTransferUs;
+    stats.transfers++;
+    if (!success)
+        stats.failures++;
 
-    uint8_t buffer[Communication_DataSize];
-    if (spi_write_read_blocking(spi0, controlBuf, buffer, Communication_DataSize) != Communication_DataSize)
-    {
-        return false;
-    }
+    return success;
+}
+
+void Communication::pack(const CommunicationStatus &status, const CommunicationDistanceSensors &sensors, uint8_t *buffer)
+{
+    buffer[0] = (uint8_t)(status.version & 0xFF);
+    buffer[1] = (uint8_t)((status.version >> 8) & 0xFF);
+    buffer[2] = (uint8_t)((status.version >> 16) & 0xFF);
+    buffer[3] = (uint8_t)((status.version >> 24) & 0xFF);
+    buffer[4] = status.running ? 0xFF : 0;
 
+    std::memcpy(&buffer[5 + 0 * sizeof(float)], &sensors.distance0, sizeof(float));
+    std::memcpy(&buffer[5 + 1 * sizeof(float)], &sensors.distance1, sizeof(float));
+    std::memcpy(&buffer[5 + 2 * sizeof(float)], &sensors.distance2, sizeof(float));
+    std::memcpy(&buffer[5 + 3 * sizeof(float)], &sensors.distance3, sizeof(float));
+    std::memcpy(&buffer[5 + 4 * sizeof(float)], &sensors.distance4, sizeof(float));
+    std::memcpy(&buffer[5 + 5 * sizeof(float)], &sensors.distance5, sizeof(float));
+}
+
+void Communication::unpack(const uint8_t *buffer, CommunicationStatus *out_status, CommunicationDistanceSensors *out_sensors)
+{
     *out_status = {
         .version = ((uint32_t)buffer[0]) | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24),
         .running = buffer[4] != 0};
@@ -64,6 +101,34 @@ bool Communication::read(const CommunicationControl &control, CommunicationStatu
     std::memcpy(&out_sensors->distance3, &buffer[5 + 3 * sizeof(float)], sizeof(float));
     std::memcpy(&out_sensors->distance4, &buffer[5 + 4 * sizeof(float)], sizeof(float));
     std::memcpy(&out_sensors->distance5, &buffer[5 + 5 * sizeof(float)], sizeof(float));
+}
+
+bool Communication::read(const CommunicationControl &control, CommunicationStatus *out_status, CommunicationDistanceSensors *out_sensors)
+{
+    uint8_t controlBuf[Communication_DataSize];
+
+    controlBuf[0] = (uint8_t)control.command;
+    std::memcpy(&controlBuf[1], control.data, Communication_DataSize - 1);
+
+    if (InputCapture::isReplaying())
+    {
+        // the sense board is not asked, the latest replayed frame is its answer
+        replayFrame.read(replayBuffer, replaySequence);
+        if (replaySequence == 0)
+            return false;
+
+        unpack(replayBuffer.data(), out_status, out_sensors);
+        return true;
+    }
+
+    uint8_t buffer[Communication_DataSize];
+    if (!transfer(controlBuf, buffer))
+    {
+        return false;
+    }
+
+    InputCapture::record(InputCapture::Source::Spi, buffer, Communication_DataSize);
+    unpack(buffer, out_status, out_sensors);
 
     return true;
 }
@@ -71,22 +136,11 @@ bool Communication::read(const CommunicationControl &control, CommunicationStatu
 bool Communication::write(const CommunicationStatus &status, const CommunicationDistanceSensors &sensors, CommunicationControl *out_control)
 {
     uint8_t buffer[Communication_DataSize];
-    buffer[0] = (uint8_t)(status.version & 0xFF);
-    buffer[1] = (uint8_t)((status.version >> 8) & 0xFF);
-    buffer[2] = (uint8_t)((status.version >> 16) & 0xFF);
-    buffer[3] = (uint8_t)((status.version >> 24) & 0xFF);
-    buffer[4] = status.running ? 0xFF : 0;
-
-    std::memcpy(&buffer[5 + 0 * sizeof(float)], &sensors.distance0, sizeof(float));
-    std::memcpy(&buffer[5 + 1 * sizeof(float)], &sensors.distance1, sizeof(float));
-    std::memcpy(&buffer[5 + 2 * sizeof(float)], &sensors.distance2, sizeof(float));
-    std::memcpy(&buffer[5 + 3 * sizeof(float)], &sensors.distance3, sizeof(float));
-    std::memcpy(&buffer[5 + 4 * sizeof(float)], &sensors.distance4, sizeof(float));
-    std::memcpy(&buffer[5 + 5 * sizeof(float)], &sensors.distance5, sizeof(float));
+    pack(status, sensors, buffer);
 
     uint8_t controlBuf[Communication_DataSize];
 
-    if (spi_write_read_blocking(spi0, buffer, controlBuf, Communication_DataSize) != Communication_DataSize)
+    if (!transfer(buffer, controlBuf))
     {
         return false;
     }
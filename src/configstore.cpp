@@ -0,0 +1,231 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/flash.h>
+#include <hardware/flash.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "configstore.h"
+#include "failsafe.h"
+#include "terminal.h"
+
+struct Blob
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size; // sizeof(StoredConfig)
+    uint32_t sequence;
+    uint32_t crc; // over config
+    StoredConfig config;
+};
+
+static constexpr uint32_t BLOB_PROGRAM_SIZE = (sizeof(Blob) + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE;
+static_assert(BLOB_PROGRAM_SIZE <= FLASH_SECTOR_SIZE, "Config blob must fit one sector");
+
+static constexpr uint32_t SLOT_A_OFFSET = PICO_FLASH_SIZE_BYTES - Config::Store::FLASH_SECTORS_FROM_END * FLASH_SECTOR_SIZE;
+static constexpr uint32_t SLOT_OFFSETS[2] = {SLOT_A_OFFSET, SLOT_A_OFFSET + FLASH_SECTOR_SIZE};
+
+static const StoredConfig DEFAULTS = {
+    Config::Drivetrain::ROBOT_WHEEL_DISTANCE.meters(),
+    Config::Drivetrain::ROBOT_MAX_SPEED.meters(),
+    Config::Drivetrain::MAX_ACCELERATION,
+    Config::Drivetrain::MAX_DECELERATION,
+
+    Config::Drivetrain::VELOCITY_GAINS.kS.raw(),
+    Config::Drivetrain::VELOCITY_GAINS.kV.raw(),
+    Config::Drivetrain::VELOCITY_GAINS.kP.raw(),
+    Config::Drivetrain::VELOCITY_GAINS.kI.raw(),
+    Config::Drivetrain::VELOCITY_GAINS.integralLimit.raw(),
+
+    Config::Control::RAMSETE_B,
+    Config::Control::RAMSETE_ZETA,
+    Config::Control::TRAJECTORY_MAX_VELOCITY,
+    Config::Control::TRAJECTORY_MAX_ACCELERATION,
+    Config::Control::TRAJECTORY_MAX_CENTRIPETAL_ACCELERATION,
+    Config::Control::TRAJECTORY_OVERRIDE_DEADBAND,
+
+    (uint32_t)Config::Control::LINK_HOLD_US,
+    (uint32_t)Config::Control::LINK_DECAY_US};
+
+static const char *SOURCE_NAMES[] = {"defaults", "slot A", "slot B"};
+
+static bool enabled = false;
+static const StoredConfig *active = &DEFAULTS;
+static ConfigSource source = ConfigSource::Defaults;
+static int bootSlot = -1;
+static uint32_t bootSequence = 0;
+static uint32_t newestSequence = 0;
+
+extern char __flash_binary_end;
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static const Blob *slot_blob(int slot)
+{
+    return (const Blob *)(XIP_BASE + SLOT_OFFSETS[slot]);
+}
+
+static bool blob_valid(const Blob *blob)
+{
+    return blob->magic == ConfigStore::MAGIC && blob->version == ConfigStore::VERSION && blob->size == sizeof(StoredConfig) &&
+           blob->crc == crc32((const uint8_t *)&blob->config, sizeof(StoredConfig));
+}
+
+struct ProgramJob
+{
+    uint32_t offset;
+    const uint8_t *data;
+};
+
+/// @brief Runs with the other core and interrupts held off by flash_safe_execute
+static void program_slot(void *param)
+{
+    const ProgramJob *job = (const ProgramJob *)param;
+    flash_range_erase(job->offset, FLASH_SECTOR_SIZE);
+    flash_range_program(job->offset, job->data, BLOB_PROGRAM_SIZE);
+}
+
+static void print_config(const StoredConfig &config)
+{
+    VelocityGains gains = config.velocityGains();
+    printf("  wheelDistance %.4f m, maxSpeed %.3f m/s, acceleration %.2f / deceleration %.2f m/s^2\n",
+           config.wheelDistance, config.maxSpeed, config.maxAcceleration, config.maxDeceleration);
+    printf("  velocity kS %.3f kV %.3f kP %.3f kI %.3f integralLimit %.3f\n",
+           gains.kS.toFloat(), gains.kV.toFloat(), gains.kP.toFloat(), gains.kI.toFloat(), gains.integralLimit.toFloat());
+    printf("  ramsete b %.3f zeta %.3f, trajectory %.2f m/s %.2f m/s^2 %.2f m/s^2 centripetal, override deadband %.2f\n",
+           config.ramseteB, config.ramseteZeta, config.trajectoryMaxVelocity, config.trajectoryMaxAcceleration,
+           config.trajectoryMaxCentripetalAcceleration, config.trajectoryOverrideDeadband);
+    printf("  link hold %lu us, decay %lu us\n", (unsigned long)config.linkHoldUs, (unsigned long)config.linkDecayUs);
+}
+
+static void config_command(int argc, char **argv, void *context)
+{
+    printf("Config: %s, sequence %lu%s\n", SOURCE_NAMES[(int)source], (unsigned long)bootSequence,
+           ConfigStore::isPending() ? ", newer config written (applies after a reboot)" : "");
+    print_config(*active);
+}
+
+void ConfigStore::init()
+{
+    Terminal::registerCommand({"config", "", "Flash config store state and loaded values", config_command, nullptr});
+
+    // the image has to end below the reserved sectors
+    if ((uintptr_t)&__flash_binary_end > XIP_BASE + SLOT_A_OFFSET)
+    {
+        printf("[Config] Image overlaps the config sectors, using defaults\n");
+        return;
+    }
+    enabled = true;
+
+    for (int slot = 0; slot < 2; slot++)
+    {
+        const Blob *blob = slot_blob(slot);
+        if (!blob_valid(blob))
+            continue;
+        if (bootSlot < 0 || (int32_t)(blob->sequence - slot_blob(bootSlot)->sequence) > 0)
+            bootSlot = slot;
+    }
+
+    if (bootSlot >= 0)
+    {
+        active = &slot_blob(bootSlot)->config;
+        source = bootSlot == 0 ? ConfigSource::SlotA : ConfigSource::SlotB;
+        bootSequence = slot_blob(bootSlot)->sequence;
+    }
+    newestSequence = bootSequence;
+
+    printf("[Config] Loaded %s, sequence %lu\n", SOURCE_NAMES[(int)source], (unsigned long)bootSequence);
+}
+
+const StoredConfig &ConfigStore::get()
+{
+    return *active;
+}
+
+const StoredConfig &ConfigStore::getDefaults()
+{
+    return DEFAULTS;
+}
+
+ConfigSource ConfigStore::getSource()
+{
+    return source;
+}
+
+uint32_t ConfigStore::getSequence()
+{
+    return bootSequence;
+}
+
+bool ConfigStore::isPending()
+{
+    return newestSequence != bootSequence;
+}
+
+static bool in_range(float value, float min, float max)
+{
+    return isfinite(value) && value >= min && value <= max;
+}
+
+bool ConfigStore::validate(const StoredConfig &config)
+{
+    VelocityGains gains = config.velocityGains();
+    return in_range(config.wheelDistance, 0.05f, 2.0f) && in_range(config.maxSpeed, 0.05f, 5.0f) &&
+           in_range(config.maxAcceleration, 0.1f, 50.0f) && in_range(config.maxDeceleration, 0.1f, 50.0f) &&
+           gains.kS >= q16_16() && gains.kV > q16_16() && gains.kP >= q16_16() && gains.kI >= q16_16() && gains.integralLimit >= q16_16() &&
+           in_range(config.ramseteB, 0.01f, 100.0f) && in_range(config.ramseteZeta, 0.01f, 1.0f) &&
+           in_range(config.trajectoryMaxVelocity, 0.01f, 5.0f) && in_range(config.trajectoryMaxAcceleration, 0.01f, 20.0f) &&
+           in_range(config.trajectoryMaxCentripetalAcceleration, 0.01f, 20.0f) && in_range(config.trajectoryOverrideDeadband, 0.0f, 0.99f) &&
+           config.linkHoldUs <= 10 * 1000 * 1000 && config.linkDecayUs <= 10 * 1000 * 1000;
+}
+
+bool ConfigStore::write(const StoredConfig &config)
+{
+    if (!enabled || !validate(config))
+        return false;
+
+    // never the boot slot, the running config points into it
+    int target = bootSlot == 0 ? 1 : 0;
+
+    static uint8_t page[BLOB_PROGRAM_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    Blob blob = {MAGIC, VERSION, (uint16_t)sizeof(StoredConfig), newestSequence + 1, crc32((const uint8_t *)&config, sizeof(config)), config};
+    memcpy(page, &blob, sizeof(blob));
+
+    ProgramJob job = {SLOT_OFFSETS[target], page};
+    // flash_safe_execute may wait for the other core before the erase starts
+    Failsafe::extendDeadline(Config::Store::FLASH_TIMEOUT_MS + Config::Store::FLASH_ERASE_MAX_MS);
+    if (flash_safe_execute(program_slot, &job, Config::Store::FLASH_TIMEOUT_MS) != PICO_OK)
+    {
+        printf("[Config] Flash write failed\n");
+        return false;
+    }
+
+    const Blob *written = slot_blob(target);
+    if (!blob_valid(written) || written->sequence != blob.sequence)
+    {
+        printf("[Config] Flash verify failed\n");
+        return false;
+    }
+
+    newestSequence = blob.sequence;
+    printf("[Config] Wrote %s, sequence %lu\n", SOURCE_NAMES[target + 1], (unsigned long)newestSequence);
+    return true;
+}
@@ -4,53 +4,88 @@
 #include <cstdarg>
 #include <cstring>
 #include <algorithm>
+#include <array>
+#include <bit>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
 
 // Hardware headers
 #include <pico/time.h>
 
 #include "control/driverstation.h"
 #include "config/options.h"
+#include "flightrecorder.h"
+#include "inputcapture.h"
+#include "failsafe.h"
 
 #include <msgpack/msgpack.hpp>
 
 using namespace std::literals;
 
-int64_t TimeoutAlarmCallback(alarm_id_t id, void *user_data)
+static DispatchClass packet_class(PacketType type)
 {
-    Driverstation *ds = (Driverstation *)user_data;
-
-    // https://stackoverflow.com/a/32780139
-    auto it = std::find_if(std::begin(ds->clients), std::end(ds->clients),
-                           [&id](auto &&p)
-                           { return p.second.pongTimeoutAlarm == id; });
-
-    if (it != std::end(ds->clients))
+    switch (type)
     {
-        ds->server->disconnectClient(it->first);
+    case PacketType::ClockSync:
+        return DispatchClass::Realtime;
+    case PacketType::Pose:
+    case PacketType::Trajectory:
+    case PacketType::TrajectoryStatus:
+        return DispatchClass::Normal;
+    default:
+        return DispatchClass::Bulk;
     }
-
-    return 0;
 }
 
-int64_t PingIntervalCallback(alarm_id_t id, void *user_data)
+/// @brief Requests without side effects. A replayed Trajectory, FlightRecord or Config frame would
+/// start a trajectory, resume the recorder or rewrite the flash config and reboot.
+static bool is_replayable(PacketType type)
 {
-    Driverstation *ds = (Driverstation *)user_data;
+    return type == PacketType::ClockSync || type == PacketType::Pose;
+}
 
-    // https://stackoverflow.com/a/32780139
-    auto it = std::find_if(std::begin(ds->clients), std::end(ds->clients),
-                           [&id](auto &&p)
-                           { return p.second.pingIntervalAlarm == id; });
+void driverstation_dispatch_task(void *pv_driverstation)
+{
+    Driverstation *ds = (Driverstation *)pv_driverstation;
 
-    if (it != std::end(ds->clients))
+    while (ds->running)
     {
-        ds->ping(it->first);
+        ds->serviceClients();
+
+        // highest class first, so a queued ClockSync goes before the rest of a bulk backlog
+        Driverstation::DispatchItem *item = nullptr;
+        for (QueueHandle_t queue : ds->queues)
+        {
+            if (xQueueReceive(queue, &item, 0) == pdTRUE)
+                break;
+        }
+
+        if (item == nullptr)
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(Config::Control::DRIVERSTATION_SERVICE_MS));
+            continue;
+        }
+
+        ds->dispatch(item);
+        delete item;
     }
 
-    return 0;
+    ds->exited = true;
+    vTaskDelete(NULL);
 }
 
-Driverstation::Driverstation() : clients({}), server(new WsServer(Config::Control::DRIVERSTATION_PORT))
+Driverstation::Driverstation() : server(new WsServer(Config::Control::DRIVERSTATION_PORT)), odometry(nullptr), follower(nullptr), drivetrain(nullptr), clients({}),
+                                 clientsMutex(xSemaphoreCreateMutex()), nextServiceUs(0), stats{}, running(true), exited(false)
 {
+    for (QueueHandle_t &queue : queues)
+        queue = xQueueCreate(Config::Control::DRIVERSTATION_QUEUE_LENGTH, sizeof(DispatchItem *));
+    critical_section_init(&statsLock);
+    if (xTaskCreate(driverstation_dispatch_task, "DriverstationThread", configMINIMAL_STACK_SIZE * 4, this, (tskIDLE_PRIORITY + 2UL), &dispatchTask) != pdPASS)
+        panic("Failed to create the DriverstationThread task");
+
     server->callbackArgs = this;
 
     server->protocolCallback = [](const std::vector<std::string> &requestedProtocols, void *args) -> std::string_view
@@ -61,21 +96,30 @@ Driverstation::Driverstation() : clients({}), server(new WsServer(Config::Contro
             return ""sv;
     };
 
+    // the server callbacks run on its tasks, pings and timeouts are handled by the dispatch task (serviceClients)
     server->clientConnected.Add([](WsServer *server, const WsServer::ClientEntry *entry, void *args)
-                                { Driverstation *ds = (Driverstation *)args;
-                                    ds->ping(entry->guid); });
+                                {
+                                    Driverstation *ds = (Driverstation *)args;
+                                    xSemaphoreTake(ds->clientsMutex, portMAX_DELAY);
+                                    ds->clients[entry->guid] = {0, time_us_64() + Config::Control::DRIVERSTATION_TIMEOUT_MS * 1000ull};
+                                    xSemaphoreGive(ds->clientsMutex);
+                                    server->ping(entry->guid); });
 
     server->clientDisconnected.Add([](WsServer *server, const Guid &guid, WebSocketStatusCode statusCode, const std::string_view &reason, void *args)
                                    {
                                         Driverstation *ds = (Driverstation *)args;
-                                        cancel_alarm(ds->clients[guid].pongTimeoutAlarm);
-                                        ds->clients.erase(guid); });
+                                        xSemaphoreTake(ds->clientsMutex, portMAX_DELAY);
+                                        ds->clients.erase(guid);
+                                        xSemaphoreGive(ds->clientsMutex); });
 
     server->pongCallback = [](WsServer *server, const Guid &guid, const uint8_t *payload, size_t payloadLength, void *args)
     {
         Driverstation *ds = (Driverstation *)args;
-        cancel_alarm(ds->clients[guid].pongTimeoutAlarm);
-        ds->clients[guid] = {0, add_alarm_in_ms(Config::Control::DRIVERSTATION_TIMEOUT_MS, PingIntervalCallback, ds, true)};
+        xSemaphoreTake(ds->clientsMutex, portMAX_DELAY);
+        auto it = ds->clients.find(guid);
+        if (it != ds->clients.end())
+            it->second = {time_us_64() + Config::Control::DRIVERSTATION_TIMEOUT_MS * 1000ull, 0};
+        xSemaphoreGive(ds->clientsMutex);
     };
 
     server->messageReceived.Add([](WsServer *server, const Guid &guid, const WebSocketFrame &frame, void *args)
@@ -86,13 +130,21 @@ Driverstation::Driverstation() : clients({}), server(new WsServer(Config::Contro
                                         {
                                         case WebSocketOpCode::TextFrame:
                                         {
-                                            server->send(guid, "Text frames are not supported by this protocol."sv);
+                                            Driverstation *ds = (Driverstation *)args;
+                                            ds->sendText(guid, "Text frames are not supported by this protocol."s);
                                             break;
                                         }
                                         case WebSocketOpCode::BinaryFrame:
                                         {
-                                            Driverstation *ds = (Driverstation *)args; 
-                                            ds->handleFrame(guid, frame);
+                                            if (frame.payloadLength == 0)
+                                                break;
+
+                                            // copy out of the server's frame and let the dispatch task handle it in priority order.
+                                            // Live frames keep flowing during a replay, the client connection depends on them.
+                                            Driverstation *ds = (Driverstation *)args;
+                                            InputCapture::record(InputCapture::Source::Driverstation, frame.payload, frame.payloadLength, &guid, sizeof(Guid));
+                                            ds->enqueue(packet_class((PacketType)frame.payload[0]),
+                                                        new DispatchItem{true, false, guid, std::vector<uint8_t>(frame.payload, frame.payload + frame.payloadLength), 0});
                                             break;
                                         }
                                         default:
@@ -100,56 +152,395 @@ Driverstation::Driverstation() : clients({}), server(new WsServer(Config::Contro
                                     }
                                 } });
 
+    // replayed frames carry the Guid of the client they came from, responses to it are dropped if it is gone
+    InputCapture::setReplayHandler(InputCapture::Source::Driverstation, [](const uint8_t *data, size_t length, void *context)
+                                   {
+                                       if (length <= sizeof(Guid) || !is_replayable((PacketType)data[sizeof(Guid)]))
+                                           return;
+
+                                       std::array<uint8_t, sizeof(Guid)> guidBytes;
+                                       std::copy(data, data + sizeof(Guid), guidBytes.begin());
+                                       Driverstation *ds = (Driverstation *)context;
+                                       ds->enqueue(packet_class((PacketType)data[sizeof(Guid)]),
+                                                   new DispatchItem{true, false, std::bit_cast<Guid>(guidBytes), std::vector<uint8_t>(data + sizeof(Guid), data + length), 0}); }, this);
+
     server->start();
     server->startDispatchQueue();
 }
 
 Driverstation::~Driverstation()
 {
+    InputCapture::setReplayHandler(InputCapture::Source::Driverstation, nullptr, nullptr);
+
+    running = false;
+    xTaskNotifyGive(dispatchTask);
+    while (!exited)
+        vTaskDelay(pdMS_TO_TICKS(10));
+
     delete server;
+
+    for (QueueHandle_t queue : queues)
+    {
+        DispatchItem *item;
+        while (xQueueReceive(queue, &item, 0) == pdTRUE)
+            delete item;
+        vQueueDelete(queue);
+    }
+    critical_section_deinit(&statsLock);
+    vSemaphoreDelete(clientsMutex);
+}
+
+bool Driverstation::enqueue(DispatchClass dispatchClass, DispatchItem *item)
+{
+    DispatchStats &classStats = stats[(int)dispatchClass];
+    item->queuedUs = time_us_32();
+
+    bool queued = xQueueSend(queues[(int)dispatchClass], &item, 0) == pdTRUE;
+    uint32_t depth = uxQueueMessagesWaiting(queues[(int)dispatchClass]);
+
+    critical_section_enter_blocking(&statsLock);
+    if (queued)
+        classStats.queued++;
+    else
+        classStats.dropped++;
+    if (depth > classStats.maxDepth)
+        classStats.maxDepth = depth;
+    critical_section_exit(&statsLock);
+
+    if (!queued)
+    {
+        delete item;
+        return false;
+    }
+
+    xTaskNotifyGive(dispatchTask);
+    return true;
+}
+
+void Driverstation::dispatch(DispatchItem *item)
+{
+    DispatchClass dispatchClass = item->text ? DispatchClass::Bulk : packet_class((PacketType)item->data[0]);
+    DispatchStats &classStats = stats[(int)dispatchClass];
+    uint32_t wait = time_us_32() - item->queuedUs;
+
+    critical_section_enter_blocking(&statsLock);
+    classStats.handled++;
+    classStats.lastWaitUs = wait;
+    classStats.totalWaitUs += wait;
+    if (wait > classStats.maxWaitUs)
+        classStats.maxWaitUs = wait;
+    critical_section_exit(&statsLock);
+
+    if (item->incoming)
+    {
+        handleFrame(*item->guid, item->data.data(), item->data.size());
+        return;
+    }
+
+    std::vector<Guid> guids;
+    if (!item->guid)
+    {
+        xSemaphoreTake(clientsMutex, portMAX_DELAY);
+        guids.reserve(clients.size());
+        for (const auto &client : clients)
+            guids.push_back(client.first);
+        xSemaphoreGive(clientsMutex);
+    }
+    else
+    {
+        guids.push_back(*item->guid);
+    }
+
+    for (const Guid &guid : guids)
+    {
+        if (item->text)
+            server->send(guid, std::string((const char *)item->data.data(), item->data.size()));
+        else
+            server->send(guid, item->data);
+    }
+}
+
+void Driverstation::send(const Guid &guid, PacketType type, std::vector<uint8_t> data)
+{
+    data.emplace(data.begin(), (uint8_t)type);
+    enqueue(packet_class(type), new DispatchItem{false, false, guid, std::move(data), 0});
+}
+
+void Driverstation::sendText(const Guid &guid, std::string text)
+{
+    enqueue(DispatchClass::Bulk, new DispatchItem{false, true, guid, std::vector<uint8_t>(text.begin(), text.end()), 0});
+}
+
+DispatchStats Driverstation::getStats(DispatchClass dispatchClass)
+{
+    critical_section_enter_blocking(&statsLock);
+    DispatchStats result = stats[(int)dispatchClass];
+    critical_section_exit(&statsLock);
+
+    result.depth = uxQueueMessagesWaiting(queues[(int)dispatchClass]);
+    return result;
+}
+
+void Driverstation::serviceClients()
+{
+    uint64_t now = time_us_64();
+    if (now < nextServiceUs)
+        return;
+    nextServiceUs = now + Config::Control::DRIVERSTATION_SERVICE_MS * 1000;
+
+    std::vector<Guid> pings;
+    std::vector<Guid> timeouts;
+    xSemaphoreTake(clientsMutex, portMAX_DELAY);
+    for (auto &[guid, client] : clients)
+    {
+        if (client.pongDeadlineUs != 0 && now >= client.pongDeadlineUs)
+        {
+            client = {0, 0};
+            timeouts.push_back(guid);
+        }
+        else if (client.pingDueUs != 0 && now >= client.pingDueUs)
+        {
+            client = {0, now + Config::Control::DRIVERSTATION_TIMEOUT_MS * 1000ull};
+            pings.push_back(guid);
+        }
+    }
+    xSemaphoreGive(clientsMutex);
+
+    // outside the lock, a disconnect calls back into clientDisconnected
+    for (const Guid &guid : pings)
+        server->ping(guid);
+    for (const Guid &guid : timeouts)
+        server->disconnectClient(guid);
+}
+
+bool Driverstation::hasClients()
+{
+    xSemaphoreTake(clientsMutex, portMAX_DELAY);
+    bool any = !clients.empty();
+    xSemaphoreGive(clientsMutex);
+    return any;
+}
+
+bool Driverstation::holdDrive()
+{
+    auto stopped = [this]()
+    { return drivetrain->isStopped() && (follower == nullptr || !follower->isFollowing()); };
+
+    if (drivetrain == nullptr || !stopped())
+        return false;
+
+    // a drive call already past the hold check can still post a target, the next one stops it
+    drivetrain->setHold(true);
+    vTaskDelay(pdMS_TO_TICKS(Config::Store::DRIVE_SETTLE_MS));
+    if (!stopped())
+    {
+        drivetrain->setHold(false);
+        return false;
+    }
+    return true;
 }
 
-void Driverstation::ping(const Guid &guid)
+void Driverstation::broadcast(PacketType type, std::vector<uint8_t> data)
 {
-    server->ping(guid);
-    auto pongTimeout = add_alarm_in_ms(Config::Control::DRIVERSTATION_TIMEOUT_MS, TimeoutAlarmCallback, this, true);
-    clients[guid] = {pongTimeout, clients[guid].pingIntervalAlarm};
+    data.emplace(data.begin(), (uint8_t)type);
+    enqueue(packet_class(type), new DispatchItem{false, false, std::nullopt, std::move(data), 0});
 }
 
-void Driverstation::handleFrame(const Guid &guid, const WebSocketFrame &frame)
+static TrajectoryStatusPacket make_trajectory_status_packet(const TrajectoryTracking &tracking)
 {
-    if (frame.payloadLength > 0)
+    return {get_absolute_time(), tracking.active, tracking.time, tracking.totalTime, tracking.alongError, tracking.crossError, tracking.headingError};
+}
+
+void Driverstation::publishTrajectoryStatus()
+{
+    if (follower == nullptr || !hasClients())
+        return;
+
+    broadcast(PacketType::TrajectoryStatus, msgpack::pack(make_trajectory_status_packet(follower->getTracking())));
+}
+
+static PosePacket make_pose_packet(uint64_t time, const Pose &pose)
+{
+    return {time, pose.x.toFloat(), pose.y.toFloat(), pose.heading.toFloat()};
+}
+
+void Driverstation::publishPose()
+{
+    if (odometry == nullptr || !hasClients())
+        return;
+
+    TimestampedPose pose = odometry->getPose();
+    broadcast(PacketType::Pose, msgpack::pack(make_pose_packet(pose.timeUs, pose.pose)));
+}
+
+void Driverstation::handleFrame(const Guid &guid, const uint8_t *payload, size_t payloadLength)
+{
+    if (payloadLength > 0)
     {
-        PacketType packetType = (PacketType)frame.payload[0];
+        PacketType packetType = (PacketType)payload[0];
         switch (packetType)
         {
         case PacketType::ClockSync:
         {
             std::error_code ec{};
-            auto packet = msgpack::unpack<ClockSyncRequestPacket>(&frame.payload[1], frame.payloadLength - 1, ec);
+            auto packet = msgpack::unpack<ClockSyncRequestPacket>(&payload[1], payloadLength - 1, ec);
 
             if (ec)
             {
-                server->send(guid, "Error unpacking: "s + ec.message());
+                sendText(guid, "Error unpacking: "s + ec.message());
                 break;
             }
 
             ClockSyncPacket response = {packet.clientTime, get_absolute_time()}; // populate response with client and current time
 
-            auto data = msgpack::pack(response);
-            data.emplace(data.begin(), (uint8_t)PacketType::ClockSync);
-            server->send(guid, data);
+            send(guid, PacketType::ClockSync, msgpack::pack(response));
             break;
         }
         case PacketType::RobotProperties:
         {
-            auto data = msgpack::pack(Config::ROBOT_PROPERTIES);
-            data.emplace(data.begin(), (uint8_t)PacketType::RobotProperties);
-            server->send(guid, data);
+            send(guid, PacketType::RobotProperties, msgpack::pack(Config::ROBOT_PROPERTIES));
+            break;
+        }
+        case PacketType::Pose:
+        {
+            std::error_code ec{};
+            auto packet = msgpack::unpack<PoseRequestPacket>(&payload[1], payloadLength - 1, ec);
+
+            if (ec)
+            {
+                sendText(guid, "Error unpacking: "s + ec.message());
+                break;
+            }
+
+            if (odometry == nullptr)
+            {
+                sendText(guid, "Odometry not available."s);
+                break;
+            }
+
+            PosePacket response;
+            if (packet.serverTime == 0)
+            {
+                TimestampedPose pose = odometry->getPose();
+                response = make_pose_packet(pose.timeUs, pose.pose);
+            }
+            else
+            {
+                Pose pose;
+                if (!odometry->getPoseAt(packet.serverTime, pose))
+                {
+                    sendText(guid, "Requested pose is outside the odometry history."s);
+                    break;
+                }
+                response = make_pose_packet(packet.serverTime, pose);
+            }
+
+            send(guid, PacketType::Pose, msgpack::pack(response));
+            break;
+        }
+        case PacketType::Trajectory:
+        {
+            std::error_code ec{};
+            auto packet = msgpack::unpack<TrajectoryPacket>(&payload[1], payloadLength - 1, ec);
+
+            if (ec)
+            {
+                sendText(guid, "Error unpacking: "s + ec.message());
+                break;
+            }
+
+            if (follower == nullptr || odometry == nullptr)
+            {
+                sendText(guid, "Trajectory follower not available."s);
+                break;
+            }
+
+            if (packet.waypoints.empty())
+            {
+                follower->cancel();
+            }
+            else
+            {
+                TrajectoryConstraints constraints = {
+                    packet.maxVelocity > 0 ? packet.maxVelocity : ConfigStore::get().trajectoryMaxVelocity,
+                    packet.maxAcceleration > 0 ? packet.maxAcceleration : ConfigStore::get().trajectoryMaxAcceleration,
+                    packet.maxCentripetalAcceleration > 0 ? packet.maxCentripetalAcceleration : ConfigStore::get().trajectoryMaxCentripetalAcceleration};
+
+                if (!follower->load(packet.waypoints, constraints, packet.relative, odometry->getPose().pose))
+                {
+                    sendText(guid, "Invalid trajectory."s);
+                    break;
+                }
+            }
+
+            send(guid, PacketType::TrajectoryStatus, msgpack::pack(make_trajectory_status_packet(follower->getTracking())));
+            break;
+        }
+        case PacketType::FlightRecord:
+        {
+            std::error_code ec{};
+            auto packet = msgpack::unpack<FlightRecordRequestPacket>(&payload[1], payloadLength - 1, ec);
+
+            if (ec)
+            {
+                sendText(guid, "Error unpacking: "s + ec.message());
+                break;
+            }
+
+            if (packet.action == (uint8_t)FlightRecordAction::Freeze)
+                FlightRecorder::freeze(FreezeReason::Manual);
+            else if (packet.action == (uint8_t)FlightRecordAction::Resume)
+                FlightRecorder::resume();
+
+            FlightRecordPacket response = {(uint8_t)FlightRecorder::getFreezeReason(), FlightRecorder::getCount(), packet.first, {}};
+            response.records.resize(Config::FlightRecorder::RECORDS_PER_PACKET * sizeof(::FlightRecord));
+            uint32_t copied = FlightRecorder::copy(packet.first, (::FlightRecord *)response.records.data(), Config::FlightRecorder::RECORDS_PER_PACKET);
+            response.records.resize(copied * sizeof(::FlightRecord));
+
+            send(guid, PacketType::FlightRecord, msgpack::pack(response));
+            break;
+        }
+        case PacketType::Config:
+        {
+            std::error_code ec{};
+            auto packet = msgpack::unpack<ConfigRequestPacket>(&payload[1], payloadLength - 1, ec);
+
+            if (ec)
+            {
+                sendText(guid, "Error unpacking: "s + ec.message());
+                break;
+            }
+
+            if (packet.action == (uint8_t)ConfigAction::Write || packet.action == (uint8_t)ConfigAction::Reset)
+            {
+                // the flash erase stalls both cores, the motors must not be running into it
+                if (!holdDrive())
+                {
+                    sendText(guid, "Config can only be written while the rover is stopped."s);
+                    break;
+                }
+
+                bool reset = packet.action == (uint8_t)ConfigAction::Reset;
+                bool written = ConfigStore::write(reset ? ConfigStore::getDefaults() : packet.config);
+                drivetrain->setHold(false);
+
+                if (!written)
+                {
+                    sendText(guid, reset ? "Flash write failed."s : "Config out of range or flash write failed."s);
+                    break;
+                }
+            }
+
+            ConfigPacket response = {(uint8_t)ConfigStore::getSource(), ConfigStore::getSequence(), ConfigStore::isPending(), ConfigStore::get()};
+            send(guid, PacketType::Config, msgpack::pack(response));
+
+            // the watchdog reboot leaves the dispatch task time to send the response
+            if (packet.action == (uint8_t)ConfigAction::Reboot)
+                Failsafe::reboot(Config::Store::REBOOT_DELAY_MS);
             break;
         }
         default:
-            server->send(guid, "Unsupported frame received."sv);
+            sendText(guid, "Unsupported frame received."s);
             break;
         }
     }
@@ -0,0 +1,81 @@
+// Standard headers
+#include <stdlib.h>
+
+#include "control/linkloss.h"
+
+LinkLossPolicy::LinkLossPolicy(int64_t connectedUs, int64_t holdUs, int64_t decayUs, DecayProfile profile) : connectedUs(connectedUs),
+                                                                                                            holdUs(holdUs),
+                                                                                                            decayUs(decayUs),
+                                                                                                            profile(profile),
+                                                                                                            phase(LinkLossPhase::Stopped),
+                                                                                                            stats({}),
+                                                                                                            lastForward(Units<float>::meters(0)),
+                                                                                                            lastRotation(Units<float>::radians(0)),
+                                                                                                            scale(0.0f)
+{
+}
+
+void LinkLossPolicy::enterPhase(LinkLossPhase next)
+{
+    if (next == phase)
+        return;
+
+    switch (next)
+    {
+    case LinkLossPhase::Connected:
+        if (phase == LinkLossPhase::Hold || phase == LinkLossPhase::Decay)
+            stats.recoveries++;
+        break;
+    case LinkLossPhase::Hold:
+        stats.holds++;
+        break;
+    case LinkLossPhase::Decay:
+        stats.decays++;
+        break;
+    case LinkLossPhase::Stopped:
+        stats.stops++;
+        break;
+    }
+
+    phase = next;
+}
+
+bool LinkLossPolicy::update(int64_t packetAgeUs, Units<float> forward, Units<float> rotation)
+{
+    if (packetAgeUs <= connectedUs)
+    {
+        enterPhase(LinkLossPhase::Connected);
+        lastForward = forward;
+        lastRotation = rotation;
+        scale = 1.0f;
+        return true;
+    }
+
+    // a link that was already stopped stays stopped, never resume a stale command
+    if (phase == LinkLossPhase::Stopped)
+    {
+        scale = 0.0f;
+        return false;
+    }
+
+    int64_t lostUs = packetAgeUs - connectedUs;
+    if (lostUs <= holdUs)
+    {
+        enterPhase(LinkLossPhase::Hold);
+        scale = 1.0f;
+        return true;
+    }
+
+    int64_t decayedUs = lostUs - holdUs;
+    if (profile != DecayProfile::Step && decayedUs < decayUs)
+    {
+        enterPhase(LinkLossPhase::Decay);
+        float remaining = 1.0f - (float)decayedUs / (float)decayUs;
+        scale = profile == DecayProfile::Quadratic ? remaining * remaining : remaining;
+        return true;
+    }
+
+    enterPhase(LinkLossPhase::Stopped);
+    scale = 0.0f;
+    return false;
+}
@@ -0,0 +1,73 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+
+// Libraries
+#include <lwip/udp.h>
+#include <lwip/pbuf.h>
+#include <lwip/tcpip.h>
+
+#include "control/rawudpsocket.h"
+
+// fallback for datagrams split over a pbuf chain, only touched on the tcpip thread
+static uint8_t chainBuffer[512];
+
+RawUdpSocket::RawUdpSocket(int port) : callbackArgs(nullptr), receiveCallback(nullptr), pcb(nullptr), received(0)
+{
+    LOCK_TCPIP_CORE();
+    pcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb != nullptr)
+    {
+        if (udp_bind(pcb, IP_ANY_TYPE, port) == ERR_OK)
+        {
+            udp_recv(pcb, receive, this);
+        }
+        else
+        {
+            udp_remove(pcb);
+            pcb = nullptr;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if (pcb == nullptr)
+        printf("[UDP] Error binding raw socket to port %i\n", port);
+}
+
+RawUdpSocket::~RawUdpSocket()
+{
+    if (pcb != nullptr)
+    {
+        LOCK_TCPIP_CORE();
+        udp_remove(pcb);
+        UNLOCK_TCPIP_CORE();
+    }
+}
+
+void RawUdpSocket::receive(void *arg, udp_pcb *pcb, pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    RawUdpSocket *socket = (RawUdpSocket *)arg;
+    socket->received = socket->received + 1;
+
+    if (socket->receiveCallback != nullptr)
+    {
+        RawDatagram datagram;
+        if (p->len == p->tot_len)
+        {
+            // single pbuf: decode in place
+            datagram.data = (const uint8_t *)p->payload;
+            datagram.length = p->len;
+        }
+        else
+        {
+            datagram.data = chainBuffer;
+            datagram.length = pbuf_copy_partial(p, chainBuffer, sizeof(chainBuffer), 0);
+        }
+        datagram.remoteAddress = ip4_addr_get_u32(ip_2_ip4(addr));
+        datagram.remotePort = port;
+
+        socket->receiveCallback(socket, &datagram, socket->callbackArgs);
+    }
+
+    pbuf_free(p);
+}
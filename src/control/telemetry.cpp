@@ -0,0 +1,94 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Hardware headers
+#include <pico/time.h>
+
+// Libraries
+#include <lwip/sockets.h>
+
+#include "control/telemetry.h"
+#include "config/options.h"
+
+void telemetry_task(void *pv_telemetry)
+{
+    Telemetry *telemetry = (Telemetry *)pv_telemetry;
+
+    Telemetry::Snapshot snapshot = {};
+    uint32_t lastSequence = 0;
+
+    TickType_t lastWake = xTaskGetTickCount();
+    while (telemetry->running)
+    {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(Config::Network::TELEMETRY_PERIOD_MS));
+
+        // resend the last state if nothing new was posted, the rate stays fixed
+        telemetry->mailbox.read(snapshot, lastSequence);
+        telemetry->send(snapshot);
+    }
+
+    telemetry->exited = true;
+    vTaskDelete(NULL);
+}
+
+Telemetry::Telemetry() : socket(-1), sequence(0), running(true), exited(false), stats({})
+{
+    socket = lwip_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socket < 0)
+    {
+        printf("[TELEMETRY] Error creating socket\n");
+        running = false;
+        exited = true;
+        return;
+    }
+
+    int broadcast = 1;
+    lwip_setsockopt(socket, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    if (xTaskCreate(telemetry_task, "TelemetryThread", configMINIMAL_STACK_SIZE * 2, this, (tskIDLE_PRIORITY + 2UL), &task) != pdPASS)
+        panic("Failed to create the TelemetryThread task");
+}
+
+Telemetry::~Telemetry()
+{
+    running = false;
+    while (!exited)
+        vTaskDelay(pdMS_TO_TICKS(Config::Network::TELEMETRY_PERIOD_MS));
+
+    if (socket >= 0)
+        lwip_close(socket);
+}
+
+void Telemetry::post(const Pose &pose, const FlightRecord &record)
+{
+    mailbox.post({pose, record});
+}
+
+void Telemetry::send(const Snapshot &snapshot)
+{
+    TelemetryFrame frame;
+    frame.magic = TelemetryFrame::MAGIC;
+    frame.version = TelemetryFrame::VERSION;
+    frame.size = sizeof(TelemetryFrame);
+    frame.sequence = sequence++;
+    frame.timeUs = to_us_since_boot(get_absolute_time());
+    frame.x = snapshot.pose.x.raw();
+    frame.y = snapshot.pose.y.raw();
+    frame.heading = snapshot.pose.heading.raw();
+    frame.record = snapshot.record;
+
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_port = lwip_htons(Config::Network::TELEMETRY_PORT);
+    destination.sin_addr.s_addr = ipaddr_addr(Config::Network::TELEMETRY_ADDRESS);
+
+    if (lwip_sendto(socket, &frame, sizeof(frame), 0, (const sockaddr *)&destination, sizeof(destination)) == sizeof(frame))
+        stats.sent++;
+    else
+        stats.errors++;
+}
@@ -0,0 +1,131 @@
+// Standard headers
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include "control/trajectory.h"
+
+// uniform Catmull-Rom position, p1 -> p2 as t goes 0 -> 1
+static float catmull_rom(float p0, float p1, float p2, float p3, float t)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+bool Trajectory::generate(const std::vector<float> &waypoints, const TrajectoryConstraints &constraints)
+{
+    states.clear();
+    cursor = 0;
+
+    uint32_t count = waypoints.size() / 2;
+    if (count < 2 || (count - 1) * SAMPLES_PER_SEGMENT + 1 > MAX_SAMPLES)
+        return false;
+
+    // uploaded values, a NaN, inf or far away point would reach the fixed-point drive conversion
+    if (!std::all_of(waypoints.begin(), waypoints.end(), [](float v)
+                     { return isfinite(v) && fabsf(v) <= MAX_COORDINATE; }))
+        return false;
+    for (float limit : {constraints.maxVelocity, constraints.maxAcceleration, constraints.maxCentripetalAcceleration})
+    {
+        if (!isfinite(limit) || limit <= 0.0f)
+            return false;
+    }
+
+    states.reserve((count - 1) * SAMPLES_PER_SEGMENT + 1);
+
+    auto px = [&](int i)
+    { return waypoints[2 * std::clamp(i, 0, (int)count - 1)]; };
+    auto py = [&](int i)
+    { return waypoints[2 * std::clamp(i, 0, (int)count - 1) + 1]; };
+
+    // positions
+    for (uint32_t segment = 0; segment < count - 1; segment++)
+    {
+        int i = segment;
+        for (uint32_t step = 0; step < SAMPLES_PER_SEGMENT; step++)
+        {
+            float t = (float)step / SAMPLES_PER_SEGMENT;
+            states.push_back({0, catmull_rom(px(i - 1), px(i), px(i + 1), px(i + 2), t), catmull_rom(py(i - 1), py(i), py(i + 1), py(i + 2), t), 0, 0, 0});
+        }
+    }
+    states.push_back({0, px(count - 1), py(count - 1), 0, 0, 0});
+
+    uint32_t n = states.size();
+
+    // headings along the path, curvature as heading change per distance
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t a = i == 0 ? 0 : i - 1;
+        uint32_t b = i == n - 1 ? n - 1 : i + 1;
+        states[i].heading = atan2f(states[b].y - states[a].y, states[b].x - states[a].x);
+    }
+
+    std::vector<float> distance(n, 0.0f);
+    for (uint32_t i = 1; i < n; i++)
+        distance[i] = hypotf(states[i].x - states[i - 1].x, states[i].y - states[i - 1].y);
+
+    for (uint32_t i = 1; i < n - 1; i++)
+    {
+        float ds = distance[i] + distance[i + 1];
+        states[i].curvature = ds > 0.0f ? wrap_angle(states[i + 1].heading - states[i - 1].heading) / ds : 0.0f;
+    }
+
+    // velocity limits: path speed and centripetal acceleration
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float limit = constraints.maxVelocity;
+        float k = fabsf(states[i].curvature);
+        if (k > 1e-4f)
+            limit = fminf(limit, sqrtf(constraints.maxCentripetalAcceleration / k));
+        states[i].velocity = limit;
+    }
+
+    // start and end at rest, forward pass limits acceleration, backward pass deceleration
+    states[0].velocity = 0.0f;
+    states[n - 1].velocity = 0.0f;
+    for (uint32_t i = 1; i < n; i++)
+        states[i].velocity = fminf(states[i].velocity, sqrtf(states[i - 1].velocity * states[i - 1].velocity + 2.0f * constraints.maxAcceleration * distance[i]));
+    for (uint32_t i = n - 1; i > 0; i--)
+        states[i - 1].velocity = fminf(states[i - 1].velocity, sqrtf(states[i].velocity * states[i].velocity + 2.0f * constraints.maxAcceleration * distance[i]));
+
+    // time stamps from the average velocity over each step
+    for (uint32_t i = 1; i < n; i++)
+    {
+        float v = states[i - 1].velocity + states[i].velocity;
+        states[i].time = states[i - 1].time + (v > 0.0f ? 2.0f * distance[i] / v : 0.0f);
+    }
+
+    return true;
+}
+
+TrajectoryState Trajectory::sample(float time)
+{
+    if (states.empty())
+        return {};
+    if (time <= 0.0f)
+    {
+        cursor = 0;
+        return states.front();
+    }
+    if (time >= states.back().time)
+        return states.back();
+
+    if (states[cursor].time > time)
+        cursor = 0;
+    while (cursor + 1 < states.size() && states[cursor + 1].time <= time)
+        cursor++;
+
+    const TrajectoryState &a = states[cursor];
+    const TrajectoryState &b = states[cursor + 1];
+    float span = b.time - a.time;
+    float t = span > 0.0f ? (time - a.time) / span : 0.0f;
+
+    return {
+        time,
+        a.x + (b.x - a.x) * t,
+        a.y + (b.y - a.y) * t,
+        wrap_angle(a.heading + wrap_angle(b.heading - a.heading) * t),
+        a.velocity + (b.velocity - a.velocity) * t,
+        a.curvature + (b.curvature - a.curvature) * t};
+}
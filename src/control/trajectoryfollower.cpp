@@ -0,0 +1,144 @@
+// Standard headers
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <semphr.h>
+
+// Config headers
+#include "config/options.h"
+#include "configstore.h"
+
+#include "control/trajectoryfollower.h"
+
+TrajectoryFollower::TrajectoryFollower() : mutex(xSemaphoreCreateMutex()), trajectory(nullptr), pending(false), active(false), startUs(0), tracking({}),
+                                           gains({ConfigStore::get().ramseteB, ConfigStore::get().ramseteZeta})
+{
+}
+
+TrajectoryFollower::~TrajectoryFollower()
+{
+    delete trajectory;
+    vSemaphoreDelete(mutex);
+}
+
+bool TrajectoryFollower::load(const std::vector<float> &waypoints, const TrajectoryConstraints &constraints, bool relative, const Pose &origin)
+{
+    std::vector<float> points = waypoints;
+    if (relative)
+    {
+        float c = cosf(origin.heading.toFloat());
+        float s = sinf(origin.heading.toFloat());
+        for (size_t i = 0; i + 1 < points.size(); i += 2)
+        {
+            float x = points[i];
+            float y = points[i + 1];
+            points[i] = origin.x.toFloat() + c * x - s * y;
+            points[i + 1] = origin.y.toFloat() + s * x + c * y;
+        }
+    }
+
+    // generate outside the lock, it is the expensive part
+    Trajectory *next = new Trajectory();
+    if (!next->generate(points, constraints))
+    {
+        delete next;
+        return false;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    delete trajectory;
+    trajectory = next;
+    pending = true;
+    active = false;
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void TrajectoryFollower::cancel()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    pending = false;
+    active = false;
+    tracking.active = false;
+    xSemaphoreGive(mutex);
+}
+
+bool TrajectoryFollower::isFollowing()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool following = pending || active;
+    xSemaphoreGive(mutex);
+    return following;
+}
+
+bool TrajectoryFollower::update(const Pose &pose, uint64_t timeUs, float &forward, float &rotation)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    if (pending)
+    {
+        pending = false;
+        active = true;
+        startUs = timeUs;
+    }
+
+    if (!active || trajectory == nullptr)
+    {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    float time = (timeUs - startUs) / 1000000.0f;
+    TrajectoryState reference = trajectory->sample(time);
+
+    float x = pose.x.toFloat();
+    float y = pose.y.toFloat();
+    float heading = pose.heading.toFloat();
+
+    // error in the robot frame
+    float dx = reference.x - x;
+    float dy = reference.y - y;
+    float c = cosf(heading);
+    float s = sinf(heading);
+    float ex = c * dx + s * dy;
+    float ey = -s * dx + c * dy;
+    float etheta = wrap_angle(reference.heading - heading);
+
+    // Ramsete
+    float vRef = reference.velocity;
+    float omegaRef = reference.velocity * reference.curvature;
+    float b = gains.b;
+    float k = 2.0f * gains.zeta * sqrtf(omegaRef * omegaRef + b * vRef * vRef);
+    float sinc = fabsf(etheta) < 1e-4f ? 1.0f - etheta * etheta / 6.0f : sinf(etheta) / etheta;
+
+    forward = vRef * cosf(etheta) + k * ex;
+    rotation = omegaRef + k * etheta + b * vRef * sinc * ey;
+
+    // the correction terms grow with the pose error, keep the command within what the wheels can do
+    float maxSpeed = ConfigStore::get().maxSpeed;
+    float maxRotation = 2.0f * maxSpeed / ConfigStore::get().wheelDistance; // turning in place at max wheel speed
+    forward = std::clamp(forward, -maxSpeed, maxSpeed);
+    rotation = std::clamp(rotation, -maxRotation, maxRotation);
+
+    tracking = {true, time, trajectory->getTotalTime(), ex, -ey, etheta};
+
+    if (time >= trajectory->getTotalTime())
+    {
+        active = false;
+        tracking.active = false;
+    }
+
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+TrajectoryTracking TrajectoryFollower::getTracking()
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    TrajectoryTracking copy = tracking;
+    xSemaphoreGive(mutex);
+    return copy;
+}
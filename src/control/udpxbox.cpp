@@ -9,24 +9,61 @@
 
 #include "control/udpxbox.h"
 #include "config/options.h"
+#include "inputcapture.h"
 
-UDPXbox::UDPXbox() : inputs({}), lastInputPacketTime(0), socket(new UdpSocket(Config::Control::XBOX_UDP_PORT))
+UDPXbox::UDPXbox() : inputs({}), lastInputPacketTime(0), socket(nullptr), rawSocket(nullptr)
 {
-    socket->callbackArgs = this;
-    socket->receiveCallback = [](UdpSocket *socket, Datagram *datagram, void *args)
+    if (Config::Control::XBOX_RAW_RECEIVE)
     {
-        UDPXbox *xbox = (UDPXbox *)args;
-        if (xbox->inputs.deserialize((uint8_t *)datagram->data, datagram->length) > 0)
+        rawSocket = new RawUdpSocket(Config::Control::XBOX_UDP_PORT);
+        rawSocket->callbackArgs = this;
+        rawSocket->receiveCallback = [](RawUdpSocket *socket, const RawDatagram *datagram, void *args)
         {
-            xbox->lastInputPacketTime = get_absolute_time();
-        }
-    };
+            ((UDPXbox *)args)->receive(datagram->data, datagram->length);
+        };
+    }
+    else
+    {
+        socket = new UdpSocket(Config::Control::XBOX_UDP_PORT);
+        socket->callbackArgs = this;
+        socket->receiveCallback = [](UdpSocket *socket, Datagram *datagram, void *args)
+        {
+            ((UDPXbox *)args)->receive((const uint8_t *)datagram->data, datagram->length);
+        };
+    }
+
+    InputCapture::setReplayHandler(InputCapture::Source::Xbox, [](const uint8_t *data, size_t length, void *context)
+                                   { ((UDPXbox *)context)->decode(data, length); }, this);
 }
 
 UDPXbox::~UDPXbox()
 {
-    socket->deinit();
-    delete socket;
+    InputCapture::setReplayHandler(InputCapture::Source::Xbox, nullptr, nullptr);
+
+    if (socket != nullptr)
+    {
+        socket->deinit();
+        delete socket;
+    }
+    delete rawSocket;
+}
+
+void UDPXbox::receive(const uint8_t *data, size_t length)
+{
+    // live packets would interleave with the replayed ones
+    if (InputCapture::isReplaying())
+        return;
+
+    InputCapture::record(InputCapture::Source::Xbox, data, length);
+    decode(data, length);
+}
+
+void UDPXbox::decode(const uint8_t *data, size_t length)
+{
+    if (inputs.deserialize((uint8_t *)data, length) > 0)
+    {
+        lastInputPacketTime = get_absolute_time();
+    }
 }
 
 Units<float> UDPXbox::getForward()
@@ -41,5 +78,10 @@ Units<float> UDPXbox::getRotation()
 
 bool UDPXbox::isConnected()
 {
-    return absolute_time_diff_us(lastInputPacketTime, get_absolute_time()) <= MAX_PACKET_INTERVAL_US;
+    return getPacketAge() <= MAX_PACKET_INTERVAL_US;
+}
+
+int64_t UDPXbox::getPacketAge()
+{
+    return absolute_time_diff_us(lastInputPacketTime, get_absolute_time());
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "control/velocitycontroller.h"
+
+static constexpr q16_16 MAX_DUTY = q16_16::fromInt(1);
+
+VelocityController::VelocityController(const VelocityGains &gains, q16_16 period) : gains(gains), integralStep(gains.kI * period), error(), integral()
+{
+}
+
+q16_16 VelocityController::feedforward(q16_16 setpoint)
+{
+    if (setpoint == q16_16())
+        return q16_16();
+
+    q16_16 friction = setpoint > q16_16() ? gains.kS : -gains.kS;
+    return friction + gains.kV * setpoint;
+}
+
+q16_16 VelocityController::calculate(q16_16 setpoint)
+{
+    error = q16_16();
+    integral = q16_16();
+    return clamp(feedforward(setpoint), -MAX_DUTY, MAX_DUTY);
+}
+
+q16_16 VelocityController::calculate(q16_16 setpoint, q16_16 measurement)
+{
+    // a stopped wheel should stop, not hold position against the integrator
+    if (setpoint == q16_16())
+    {
+        reset();
+        return q16_16();
+    }
+
+    error = setpoint - measurement;
+
+    q16_16 unclamped = feedforward(setpoint) + gains.kP * error + integral;
+    q16_16 output = clamp(unclamped, -MAX_DUTY, MAX_DUTY);
+
+    // anti-windup: only integrate while the output is not saturated in the error's direction
+    if (output == unclamped || (unclamped > MAX_DUTY) != (error > q16_16()))
+        integral = clamp(integral + integralStep * error, -gains.integralLimit, gains.integralLimit);
+
+    return output;
+}
+
+void VelocityController::reset()
+{
+    error = q16_16();
+    integral = q16_16();
+}
@@ -0,0 +1,84 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/time.h>
+#include <hardware/clocks.h>
+
+// Libraries
+#include <math/units.h>
+#include <kinematics/differentialdrive.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "math/fixedunits.h"
+#include "kinematics/fixeddifferentialdrive.h"
+#include "checks.h"
+#include "diagnostics.h"
+
+static constexpr int KINEMATICS_BENCH_ITERATIONS = 1000;
+
+void Diagnostics::kinematicsReport()
+{
+    DifferentialDriveKinematics floatKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE);
+    FixedDifferentialDriveKinematics<16> fixedKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE_FIXED);
+
+    Checks::KinematicsResult result = Checks::kinematics();
+
+    // timing, inputs read through volatiles so the loops are not folded away
+    volatile float floatInput = 0.7f;
+    volatile float floatRotation = 3.3f;
+    volatile int32_t fixedInput = q16_16::fromFloat(0.7f).raw();
+    volatile int32_t fixedRotation = q16_16::fromFloat(3.3f).raw();
+    volatile float floatSink;
+    volatile int32_t fixedSink;
+
+    uint32_t start = time_us_32();
+    for (int i = 0; i < KINEMATICS_BENCH_ITERATIONS; i++)
+    {
+        DifferentialDriveWheelSpeeds speeds = floatKinematics.toWheelSpeeds(ChassisSpeeds<float>(Units<float>::meters(floatInput), Units<float>::meters(0), Units<float>::radians(floatRotation)));
+        speeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED);
+        floatSink = speeds.left.meters();
+    }
+    uint32_t floatUs = time_us_32() - start;
+
+    start = time_us_32();
+    for (int i = 0; i < KINEMATICS_BENCH_ITERATIONS; i++)
+    {
+        FixedDifferentialDriveWheelSpeeds<16> speeds = fixedKinematics.toWheelSpeeds({q16_16::fromRaw(fixedInput), q16_16(), q16_16::fromRaw(fixedRotation)});
+        speeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED_FIXED.meters());
+        fixedSink = speeds.left.raw();
+    }
+    uint32_t fixedUs = time_us_32() - start;
+
+    (void)floatSink;
+    (void)fixedSink;
+
+    uint32_t cyclesPerUs = clock_get_hz(clk_sys) / 1000000;
+    printf("[KIN] %s: max error %li LSB (limit %li) over %i samples\n", result.pass ? "PASS" : "FAIL",
+           (long)result.maxErrorLsb, (long)Checks::KINEMATICS_MAX_ERROR_LSB, result.samples);
+    printf("[KIN] float %lu cycles/call, fixed %lu cycles/call\n",
+           (unsigned long)(floatUs * cyclesPerUs / KINEMATICS_BENCH_ITERATIONS),
+           (unsigned long)(fixedUs * cyclesPerUs / KINEMATICS_BENCH_ITERATIONS));
+}
+
+static void velocity_step_response(const char *name, bool closedLoop)
+{
+    uint32_t start = time_us_32();
+    Checks::StepResponse response = Checks::velocityStep(closedLoop);
+    uint32_t elapsedUs = time_us_32() - start;
+
+    int steps = (int)(Checks::VELOCITY_SIM_SECONDS * 1000.0f / Config::Drivetrain::OUTPUT_PERIOD_MS);
+    printf("[VEL] %s%s: final %.3f m/s (error %.3f), rise %.3f s, overshoot %.1f%%, %lu us/step\n",
+           closedLoop ? (response.pass ? "PASS " : "FAIL ") : "", name, response.finalVelocity, response.error,
+           response.riseTime, response.overshoot * 100.0f, (unsigned long)(elapsedUs / steps));
+}
+
+void Diagnostics::velocityControllerReport()
+{
+    velocity_step_response("feedforward", false);
+    velocity_step_response("closed loop", true);
+}
@@ -0,0 +1,256 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/time.h>
+#include <hardware/timer.h>
+#include <hardware/watchdog.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "failsafe.h"
+#include "flightrecorder.h"
+#include "terminal.h"
+
+// scratch 4 to 7 belong to the SDK reboot logic
+static constexpr uint32_t MAGIC = 0x46534600; // FSF, cause in the low byte
+static constexpr uint SCRATCH_CAUSE = 0;
+static constexpr uint SCRATCH_TIME = 1;
+static constexpr uint SCRATCH_LATE = 2;
+static constexpr uint SCRATCH_STOP = 3;
+static constexpr uint32_t WATCHDOG_MAX_MS = 0x7FFFFF / 1000; // watchdog_enable limit, the 24-bit load counts down twice per us (RP2040-E1)
+
+static_assert(Config::Failsafe::DEADLINE_US / 1000 < Config::Failsafe::WATCHDOG_TIMEOUT_MS, "The deadline has to trip before the watchdog resets");
+// extendDeadline stretches the watchdog for a config write: the wait for the other core plus the erase
+static_assert(Config::Store::FLASH_TIMEOUT_MS + Config::Store::FLASH_ERASE_MAX_MS + Config::Failsafe::WATCHDOG_TIMEOUT_MS <= WATCHDOG_MAX_MS,
+              "A config write must fit in the watchdog load");
+
+static const char *CAUSE_NAMES[] = {"none", "deadline", "panic", "hard fault", "manual", "requested", "watchdog", "output stall"};
+
+static FailsafeReport lastReset = {};
+static FailsafeReport tripReport = {}; // this session
+
+static MotorOutputs *volatile outputs = nullptr;
+static DriveOutput *driveOutput = nullptr;
+static uint32_t lastOutputTicks = 0;
+static volatile uint64_t outputProgressUs = 0; // last feed that saw the output tick, or the end of an extension
+static volatile bool watchdogExtended = false;
+static volatile uint64_t extensionEndUs = 0;
+static int alarmNum = -1;
+static volatile bool armed = false;
+static volatile bool tripped = false;
+static volatile bool holdFeed = false; // tripped or rebooting, the watchdog is left to run out
+static volatile uint64_t deadlineUs = 0;
+
+static uint32_t feeds = 0;
+static uint32_t maxFeedIntervalUs = 0;
+static uint64_t lastFeedUs = 0;
+
+static void __not_in_flash_func(record_cause)(const FailsafeReport &report)
+{
+    watchdog_hw->scratch[SCRATCH_TIME] = report.timeUs;
+    watchdog_hw->scratch[SCRATCH_LATE] = report.lateUs;
+    watchdog_hw->scratch[SCRATCH_STOP] = report.stopUs;
+    // last, it marks the others valid
+    watchdog_hw->scratch[SCRATCH_CAUSE] = MAGIC | (uint8_t)report.cause;
+}
+
+static void __not_in_flash_func(deadline_irq)(uint alarm)
+{
+    // disarmed by a requested reboot while this was already pending
+    if (!armed)
+        return;
+
+    // a feed or extendDeadline racing the alarm moved the deadline out
+    if (time_us_64() < deadlineUs)
+    {
+        hardware_alarm_set_target(alarm, from_us_since_boot(deadlineUs));
+        return;
+    }
+
+    Failsafe::trip(FailsafeCause::Deadline);
+    FlightRecorder::freeze(FreezeReason::Failsafe);
+}
+
+static void print_report(const char *label, const FailsafeReport &report)
+{
+    printf("%s: %s", label, CAUSE_NAMES[(int)report.cause]);
+    if (report.cause != FailsafeCause::None && report.cause != FailsafeCause::Watchdog)
+        printf(" at %lu us, %lu us late, motors off in %lu us", (unsigned long)report.timeUs, (unsigned long)report.lateUs, (unsigned long)report.stopUs);
+    printf("\n");
+}
+
+static void failsafe_command(int argc, char **argv, void *context)
+{
+    if (argc > 1 && strcmp(argv[1], "trip") == 0)
+    {
+        Failsafe::trip(FailsafeCause::Manual);
+        FlightRecorder::freeze(FreezeReason::Failsafe);
+        printf("Motors stopped, the watchdog resets in %lu ms\n", (unsigned long)Config::Failsafe::WATCHDOG_TIMEOUT_MS);
+        return;
+    }
+
+    printf("Failsafe: %s, deadline %lu us, watchdog %lu ms, alarm %d\n", tripped ? "tripped" : (armed ? "armed" : "not armed"),
+           (unsigned long)Config::Failsafe::DEADLINE_US, (unsigned long)Config::Failsafe::WATCHDOG_TIMEOUT_MS, alarmNum);
+    printf("Feeds: %lu, max interval %lu us\n", (unsigned long)feeds, (unsigned long)maxFeedIntervalUs);
+    if (tripped)
+        print_report("Tripped", tripReport);
+    print_report("Last reset", lastReset);
+}
+
+void Failsafe::init()
+{
+    uint32_t tag = watchdog_hw->scratch[SCRATCH_CAUSE];
+    if ((tag & ~0xFFu) == MAGIC && (tag & 0xFF) <= (uint32_t)FailsafeCause::OutputStall)
+    {
+        lastReset = {(FailsafeCause)(tag & 0xFF), watchdog_hw->scratch[SCRATCH_TIME], watchdog_hw->scratch[SCRATCH_LATE], watchdog_hw->scratch[SCRATCH_STOP]};
+    }
+    else if (watchdog_caused_reboot())
+    {
+        lastReset = {FailsafeCause::Watchdog, 0, 0, 0};
+    }
+    watchdog_hw->scratch[SCRATCH_CAUSE] = 0;
+
+    Terminal::registerCommand({"failsafe", "[trip]", "Failsafe deadline state and the cause of the last reset", failsafe_command, nullptr});
+
+    if (lastReset.cause != FailsafeCause::None)
+        print_report("[Failsafe] Last reset", lastReset);
+}
+
+void Failsafe::start(MotorOutputs *motorOutputs, DriveOutput *output)
+{
+    outputs = motorOutputs;
+    driveOutput = output;
+    lastOutputTicks = output->getTicks();
+    outputProgressUs = time_us_64();
+
+    alarmNum = hardware_alarm_claim_unused(false);
+    if (alarmNum < 0)
+        printf("[Failsafe] No free hardware alarm, watchdog only\n");
+    else
+        hardware_alarm_set_callback(alarmNum, deadline_irq);
+
+    armed = true;
+    feed();
+    watchdog_enable(Config::Failsafe::WATCHDOG_TIMEOUT_MS, true);
+
+    printf("[Failsafe] Armed, deadline %lu us, watchdog %lu ms\n", (unsigned long)Config::Failsafe::DEADLINE_US,
+           (unsigned long)Config::Failsafe::WATCHDOG_TIMEOUT_MS);
+}
+
+static void set_deadline(uint64_t us)
+{
+    deadlineUs = us;
+    if (alarmNum >= 0)
+        hardware_alarm_set_target(alarmNum, from_us_since_boot(us));
+    watchdog_update();
+}
+
+void Failsafe::feed()
+{
+    if (!armed || holdFeed)
+        return;
+
+    uint64_t now = time_us_64();
+    if (lastFeedUs != 0 && now - lastFeedUs > maxFeedIntervalUs)
+        maxFeedIntervalUs = (uint32_t)(now - lastFeedUs);
+    lastFeedUs = now;
+    feeds++;
+
+    // back to the normal timeout once the stall is over, not before (the writer may not have started it yet)
+    if (watchdogExtended && now >= extensionEndUs)
+    {
+        watchdogExtended = false;
+        watchdog_enable(Config::Failsafe::WATCHDOG_TIMEOUT_MS, true);
+    }
+
+    // the control loop running is not enough, the output task on the other core writes the PWM levels
+    uint32_t ticks = driveOutput->getTicks();
+    if (ticks != lastOutputTicks)
+    {
+        lastOutputTicks = ticks;
+        outputProgressUs = now;
+    }
+    else if ((int64_t)(now - outputProgressUs) > (int64_t)Config::Failsafe::DEADLINE_US)
+    {
+        trip(FailsafeCause::OutputStall);
+        FlightRecorder::freeze(FreezeReason::Failsafe);
+        return;
+    }
+
+    set_deadline(now + Config::Failsafe::DEADLINE_US);
+}
+
+void Failsafe::extendDeadline(uint32_t ms)
+{
+    if (!armed || holdFeed)
+        return;
+
+    // the stall stops the output task as well, and nothing feeds the watchdog during it
+    uint64_t end = time_us_64() + (uint64_t)ms * 1000;
+    outputProgressUs = end;
+    extensionEndUs = end;
+    watchdogExtended = true;
+    watchdog_enable(ms + Config::Failsafe::WATCHDOG_TIMEOUT_MS, true);
+    set_deadline(end + Config::Failsafe::DEADLINE_US);
+}
+
+void __not_in_flash_func(Failsafe::trip)(FailsafeCause cause)
+{
+    uint64_t entryUs = time_us_64();
+
+    // first cause wins, e.g. a panic while the deadline trip is running
+    if (tripped)
+        return;
+    tripped = true;
+    holdFeed = true;
+
+    MotorOutputs *target = outputs;
+    if (target != nullptr)
+        target->forceStop();
+
+    tripReport = {cause, (uint32_t)entryUs, cause == FailsafeCause::Deadline && entryUs > deadlineUs ? (uint32_t)(entryUs - deadlineUs) : 0,
+                  (uint32_t)(time_us_64() - entryUs)};
+    record_cause(tripReport);
+
+    // something has to reset the chip, also for a trip before start()
+    if (!armed)
+        watchdog_enable(Config::Failsafe::WATCHDOG_TIMEOUT_MS, true);
+}
+
+void Failsafe::reboot(uint32_t delayMs)
+{
+    // feeding would reload the watchdog with the reboot delay forever, and without feeds the
+    // deadline would trip long before it and report the reboot as a Deadline
+    holdFeed = true;
+    armed = false;
+    if (alarmNum >= 0)
+        hardware_alarm_cancel(alarmNum);
+
+    // a trip before this already stopped the motors, its cause is the one to keep
+    if (!tripped)
+        record_cause({FailsafeCause::Requested, time_us_32(), 0, 0});
+    watchdog_reboot(0, 0, delayMs);
+}
+
+bool Failsafe::isTripped()
+{
+    return tripped;
+}
+
+const FailsafeReport &Failsafe::getLastReset()
+{
+    return lastReset;
+}
+
+/// @brief Replaces the SDK's breakpoint handler, the watchdog enabled by trip resets the chip
+extern "C" void __not_in_flash_func(isr_hardfault)()
+{
+    Failsafe::trip(FailsafeCause::HardFault);
+    while (true)
+        tight_loop_contents();
+}
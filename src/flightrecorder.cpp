@@ -0,0 +1,93 @@
+// Standard headers
+#include <stdlib.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/critical_section.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "flightrecorder.h"
+
+static constexpr uint32_t MAGIC = 0x46524543; // FREC
+
+struct Recording
+{
+    uint32_t magic;
+    volatile FreezeReason reason;
+    uint32_t head; // total records written, wraps the ring
+    FlightRecord records[Config::FlightRecorder::RECORD_COUNT];
+};
+
+// not cleared at boot, see FlightRecorder::init
+static Recording __uninitialized_ram(recording);
+static critical_section_t lock;
+
+void FlightRecorder::init()
+{
+    critical_section_init(&lock);
+
+    // keep a frozen recording from before the reset, anything else is garbage
+    if (recording.magic != MAGIC || recording.reason == FreezeReason::None || recording.head == 0)
+    {
+        recording.magic = MAGIC;
+        recording.reason = FreezeReason::None;
+        recording.head = 0;
+    }
+}
+
+void FlightRecorder::record(const FlightRecord &record)
+{
+    if (recording.reason != FreezeReason::None)
+        return;
+
+    critical_section_enter_blocking(&lock);
+    recording.records[recording.head % Config::FlightRecorder::RECORD_COUNT] = record;
+    recording.head++;
+    critical_section_exit(&lock);
+}
+
+void FlightRecorder::freeze(FreezeReason reason)
+{
+    // no lock, this is also called from the panic handler
+    if (recording.reason == FreezeReason::None)
+        recording.reason = reason;
+}
+
+void FlightRecorder::resume()
+{
+    critical_section_enter_blocking(&lock);
+    recording.head = 0;
+    recording.reason = FreezeReason::None;
+    critical_section_exit(&lock);
+}
+
+FreezeReason FlightRecorder::getFreezeReason()
+{
+    return recording.reason;
+}
+
+bool FlightRecorder::isFrozen()
+{
+    return recording.reason != FreezeReason::None;
+}
+
+uint32_t FlightRecorder::getCount()
+{
+    return recording.head < Config::FlightRecorder::RECORD_COUNT ? recording.head : Config::FlightRecorder::RECORD_COUNT;
+}
+
+uint32_t FlightRecorder::copy(uint32_t first, FlightRecord *out, uint32_t max)
+{
+    critical_section_enter_blocking(&lock);
+
+    uint32_t count = getCount();
+    uint32_t oldest = recording.head - count;
+    uint32_t copied = 0;
+    for (uint32_t i = first; i < count && copied < max; i++)
+        out[copied++] = recording.records[(oldest + i) % Config::FlightRecorder::RECORD_COUNT];
+
+    critical_section_exit(&lock);
+    return copied;
+}
@@ -0,0 +1,258 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/critical_section.h>
+
+// Libraries
+#include <wsserver.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "inputcapture.h"
+#include "terminal.h"
+
+using InputCapture::Mode;
+using InputCapture::RecordHeader;
+using InputCapture::Source;
+
+static_assert(std::is_trivially_copyable_v<Guid>, "Driverstation records store the Guid bytes");
+
+struct Handler
+{
+    InputCapture::ReplayHandler handler;
+    void *context;
+};
+
+static const char *MODE_NAMES[] = {"idle", "capturing", "replaying"};
+
+// allocated on the first capture or load, most runs never pay for it
+static uint8_t *buffer = nullptr;
+static uint32_t used = 0;
+static uint64_t captureStartUs = 0;
+static volatile Mode mode = Mode::Idle;
+static InputCapture::Stats stats = {};
+static Handler handlers[(int)Source::Count] = {};
+static critical_section_t lock;
+
+static TaskHandle_t replayTask;
+static volatile bool replayRunning = false;
+
+static bool ensure_buffer()
+{
+    if (buffer == nullptr)
+        buffer = new uint8_t[Config::Capture::BUFFER_SIZE];
+    return buffer != nullptr;
+}
+
+static InputCapture::Header make_header()
+{
+    return {InputCapture::MAGIC, InputCapture::VERSION, (uint16_t)sizeof(Guid), stats.records, used};
+}
+
+static void capture_replay_task(__unused void *params)
+{
+    uint64_t startUs = time_us_64();
+    uint32_t offset = 0;
+
+    while (mode == Mode::Replaying && offset < used)
+    {
+        RecordHeader header;
+        memcpy(&header, &buffer[offset], sizeof(header));
+        const uint8_t *data = &buffer[offset + sizeof(header)];
+        offset += sizeof(header) + header.length;
+
+        // sleeps in ticks, records closer together than a tick are delivered up to one tick late
+        uint64_t due = startUs + header.timeUs;
+        while (mode == Mode::Replaying && (int64_t)(due - time_us_64()) > 0)
+            vTaskDelay(1);
+        uint32_t late = (uint32_t)(time_us_64() - due);
+
+        if (mode != Mode::Replaying)
+            break;
+
+        if (header.source < (uint8_t)Source::Count && handlers[header.source].handler != nullptr)
+            handlers[header.source].handler(data, header.length, handlers[header.source].context);
+
+        critical_section_enter_blocking(&lock);
+        stats.replayed++;
+        stats.lastLateUs = late;
+        if (late > stats.maxLateUs)
+            stats.maxLateUs = late;
+        critical_section_exit(&lock);
+    }
+
+    if (mode == Mode::Replaying)
+        mode = Mode::Idle;
+    printf("[Capture] Replay finished, %lu records, max %lu us late\n", (unsigned long)stats.replayed, (unsigned long)stats.maxLateUs);
+
+    replayRunning = false;
+    vTaskDelete(NULL);
+}
+
+static void capture_command(int argc, char **argv, void *context)
+{
+    if (argc == 1)
+    {
+        InputCapture::Stats current = InputCapture::getStats();
+        printf("Capture: %s, %lu records, %lu/%u bytes, %lu dropped, %lu replayed (last %lu us late, max %lu us)\n", MODE_NAMES[(int)current.mode],
+               (unsigned long)current.records, (unsigned long)current.bytes, Config::Capture::BUFFER_SIZE, (unsigned long)current.dropped,
+               (unsigned long)current.replayed, (unsigned long)current.lastLateUs, (unsigned long)current.maxLateUs);
+        return;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "start") == 0)
+    {
+        if (!InputCapture::start())
+            printf("Capture busy\n");
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "stop") == 0)
+    {
+        InputCapture::stop();
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "replay") == 0)
+    {
+        if (!InputCapture::replay())
+            printf("Nothing to replay, or capture busy\n");
+        return;
+    }
+    if (argc == 2 && strcmp(argv[1], "dump") == 0)
+    {
+        InputCapture::dump();
+        return;
+    }
+    printf("Usage: capture [start|stop|replay|dump]\n");
+}
+
+void InputCapture::init()
+{
+    critical_section_init(&lock);
+
+    Terminal::registerCommand({"capture", "[start|stop|replay|dump]", "Record and replay Xbox, driverstation and SPI input", capture_command, nullptr});
+}
+
+void InputCapture::record(Source source, const uint8_t *data, size_t length, const void *prefix, size_t prefixLength)
+{
+    if (mode != Mode::Capturing)
+        return;
+
+    size_t payloadLength = prefixLength + length;
+
+    critical_section_enter_blocking(&lock);
+    if (mode != Mode::Capturing)
+    {
+        critical_section_exit(&lock);
+        return;
+    }
+
+    if (payloadLength > UINT16_MAX || used + sizeof(RecordHeader) + payloadLength > Config::Capture::BUFFER_SIZE)
+    {
+        stats.dropped++;
+        critical_section_exit(&lock);
+        return;
+    }
+
+    // stamped under the lock so the log stays in time order across cores
+    RecordHeader header = {(uint32_t)(time_us_64() - captureStartUs), (uint16_t)payloadLength, (uint8_t)source, 0};
+    memcpy(&buffer[used], &header, sizeof(header));
+    if (prefixLength > 0)
+        memcpy(&buffer[used + sizeof(header)], prefix, prefixLength);
+    memcpy(&buffer[used + sizeof(header) + prefixLength], data, length);
+
+    used += sizeof(header) + payloadLength;
+    stats.records++;
+    stats.bytes = used;
+    critical_section_exit(&lock);
+}
+
+bool InputCapture::isReplaying()
+{
+    return mode == Mode::Replaying;
+}
+
+void InputCapture::setReplayHandler(Source source, ReplayHandler handler, void *context)
+{
+    critical_section_enter_blocking(&lock);
+    handlers[(int)source] = {handler, context};
+    critical_section_exit(&lock);
+}
+
+bool InputCapture::start()
+{
+    if (mode == Mode::Replaying || replayRunning || !ensure_buffer())
+        return false;
+
+    critical_section_enter_blocking(&lock);
+    used = 0;
+    stats = {};
+    captureStartUs = time_us_64();
+    mode = Mode::Capturing;
+    critical_section_exit(&lock);
+    return true;
+}
+
+void InputCapture::stop()
+{
+    mode = Mode::Idle;
+}
+
+bool InputCapture::replay()
+{
+    if (mode != Mode::Idle || replayRunning || used == 0)
+        return false;
+
+    critical_section_enter_blocking(&lock);
+    stats.replayed = 0;
+    stats.lastLateUs = 0;
+    stats.maxLateUs = 0;
+    mode = Mode::Replaying;
+    critical_section_exit(&lock);
+
+    replayRunning = true;
+    xTaskCreate(capture_replay_task, "CaptureReplay", configMINIMAL_STACK_SIZE * 4, NULL, (tskIDLE_PRIORITY + 3UL), &replayTask);
+    return true;
+}
+
+InputCapture::Stats InputCapture::getStats()
+{
+    critical_section_enter_blocking(&lock);
+    Stats result = stats;
+    critical_section_exit(&lock);
+
+    result.mode = mode;
+    return result;
+}
+
+static void dump_bytes(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i += Config::Capture::DUMP_LINE_BYTES)
+    {
+        for (size_t j = i; j < length && j < i + Config::Capture::DUMP_LINE_BYTES; j++)
+            printf("%02x", data[j]);
+        putchar('\n');
+    }
+}
+
+void InputCapture::dump()
+{
+    if (mode != Mode::Idle || used == 0)
+    {
+        printf("Nothing to dump, or capture busy\n");
+        return;
+    }
+
+    Header header = make_header();
+    dump_bytes((const uint8_t *)&header, sizeof(header));
+    dump_bytes(buffer, used);
+}
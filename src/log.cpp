@@ -0,0 +1,336 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <hardware/sync.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "log.h"
+#include "terminal.h"
+
+static_assert((Config::Logging::RING_LENGTH & (Config::Logging::RING_LENGTH - 1)) == 0, "Log ring length must be a power of two");
+
+struct Entry
+{
+    Log::Site *site;
+    uint32_t timeUs;
+    uint32_t suppressed;
+    uint32_t args[Log::MAX_ARGS];
+};
+
+// Single producer per core: writers disable interrupts on their own core, so no lock is
+// shared between cores. The formatter task is the only consumer.
+struct Ring
+{
+    Entry entries[Config::Logging::RING_LENGTH];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+
+    volatile uint32_t written;
+    volatile uint32_t dropped;
+    volatile uint32_t suppressed;
+};
+
+static Ring rings[NUM_CORES];
+
+static Entry history[Config::Logging::HISTORY_LENGTH];
+static uint32_t historyCount = 0;
+
+static volatile Log::Level minLevel = Log::Level::Info;
+static volatile bool outputEnabled = true;
+
+static TaskHandle_t task;
+static volatile bool isRunning = false;
+
+void Log::write(Site &site, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    if (site.level < minLevel)
+        return;
+
+    uint32_t now = time_us_32();
+    uint32_t irq = save_and_disable_interrupts();
+    Ring &ring = rings[get_core_num()];
+
+    if (site.written && now - site.lastUs < site.minIntervalUs)
+    {
+        site.suppressed = site.suppressed + 1;
+        ring.suppressed = ring.suppressed + 1;
+        restore_interrupts(irq);
+        return;
+    }
+
+    if (ring.head - ring.tail >= Config::Logging::RING_LENGTH)
+    {
+        ring.dropped = ring.dropped + 1;
+        restore_interrupts(irq);
+        return;
+    }
+
+    Entry &entry = ring.entries[ring.head & (Config::Logging::RING_LENGTH - 1)];
+    entry.site = &site;
+    entry.timeUs = now;
+    entry.suppressed = site.suppressed;
+    entry.args[0] = a0;
+    entry.args[1] = a1;
+    entry.args[2] = a2;
+    entry.args[3] = a3;
+
+    site.lastUs = now;
+    site.written = true;
+    site.suppressed = 0;
+
+    // publish the entry before the consumer can see the new head
+    __dmb();
+    ring.head = ring.head + 1;
+    ring.written = ring.written + 1;
+
+    restore_interrupts(irq);
+}
+
+static float word_to_float(uint32_t word)
+{
+    float f;
+    memcpy(&f, &word, sizeof(f));
+    return f;
+}
+
+/// @brief printf with raw argument words, one conversion at a time (the argument types come from the format)
+static void print_entry(const Entry &entry)
+{
+    printf("%lu.%03lu ", (unsigned long)(entry.timeUs / 1000000), (unsigned long)(entry.timeUs / 1000 % 1000));
+
+    const char *cursor = entry.site->format;
+    int arg = 0;
+    while (*cursor != 0)
+    {
+        const char *percent = strchr(cursor, '%');
+        if (percent == nullptr)
+        {
+            fputs(cursor, stdout);
+            break;
+        }
+
+        fwrite(cursor, 1, percent - cursor, stdout);
+
+        if (percent[1] == '%')
+        {
+            putchar('%');
+            cursor = percent + 2;
+            continue;
+        }
+
+        // copy flags, width and precision, drop length modifiers (arguments are 32-bit words)
+        char spec[16];
+        size_t length = 0;
+        const char *c = percent;
+        spec[length++] = *c++;
+        while (*c != 0 && strchr("-+ #0123456789.", *c) != nullptr && length < sizeof(spec) - 3)
+            spec[length++] = *c++;
+        while (*c != 0 && strchr("hlLjzt", *c) != nullptr)
+            c++;
+
+        char conversion = *c;
+        if (conversion == 0)
+            break;
+        cursor = c + 1;
+
+        uint32_t word = arg < Log::MAX_ARGS ? entry.args[arg++] : 0;
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            spec[length++] = 'l';
+            spec[length++] = conversion;
+            spec[length] = 0;
+            printf(spec, (long)(int32_t)word);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec[length++] = 'l';
+            spec[length++] = conversion;
+            spec[length] = 0;
+            printf(spec, (unsigned long)word);
+            break;
+        case 'c':
+            spec[length++] = conversion;
+            spec[length] = 0;
+            printf(spec, (int)word);
+            break;
+        case 'p':
+            spec[length++] = conversion;
+            spec[length] = 0;
+            printf(spec, (void *)(uintptr_t)word);
+            break;
+        case 's': // string literals only, the pointer is dereferenced later
+            spec[length++] = conversion;
+            spec[length] = 0;
+            printf(spec, (const char *)(uintptr_t)word);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            spec[length++] = conversion;
+            spec[length] = 0;
+            printf(spec, (double)word_to_float(word));
+            break;
+        default:
+            fputs("<?>", stdout);
+            break;
+        }
+    }
+
+    if (entry.suppressed > 0)
+        printf(" (%lu suppressed)", (unsigned long)entry.suppressed);
+    putchar('\n');
+}
+
+/// @brief Takes the oldest pending entry across all cores
+static bool take_entry(Entry &out)
+{
+    Ring *oldest = nullptr;
+    for (Ring &ring : rings)
+    {
+        if (ring.tail == ring.head)
+            continue;
+
+        const Entry &front = ring.entries[ring.tail & (Config::Logging::RING_LENGTH - 1)];
+        if (oldest == nullptr || (int32_t)(front.timeUs - oldest->entries[oldest->tail & (Config::Logging::RING_LENGTH - 1)].timeUs) < 0)
+            oldest = &ring;
+    }
+
+    if (oldest == nullptr)
+        return false;
+
+    __dmb();
+    out = oldest->entries[oldest->tail & (Config::Logging::RING_LENGTH - 1)];
+    __dmb();
+    oldest->tail = oldest->tail + 1;
+    return true;
+}
+
+static void log_task(__unused void *params)
+{
+    while (isRunning)
+    {
+        Entry entry;
+        while (take_entry(entry))
+        {
+            history[historyCount % Config::Logging::HISTORY_LENGTH] = entry;
+            historyCount++;
+
+            if (outputEnabled)
+                print_entry(entry);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(Config::Logging::FLUSH_PERIOD_MS));
+    }
+
+    vTaskDelete(NULL);
+}
+
+static const char *LEVEL_NAMES[] = {"debug", "info", "warning", "error"};
+
+static void log_command(int argc, char **argv, void *context)
+{
+    if (argc == 1)
+    {
+        Log::Stats stats = Log::getStats();
+        printf("Log: %lu written, %lu dropped, %lu suppressed, level %s, output %s\n", (unsigned long)stats.written, (unsigned long)stats.dropped,
+               (unsigned long)stats.suppressed, LEVEL_NAMES[(int)Log::getLevel()], outputEnabled ? "on" : "off");
+        return;
+    }
+
+    if (strcmp(argv[1], "dump") == 0)
+    {
+        Log::dump();
+        return;
+    }
+
+    if (strcmp(argv[1], "on") == 0 || strcmp(argv[1], "off") == 0)
+    {
+        Log::setOutputEnabled(strcmp(argv[1], "on") == 0);
+        return;
+    }
+
+    if (strcmp(argv[1], "level") == 0 && argc == 3)
+    {
+        for (int i = 0; i < (int)(sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0])); i++)
+        {
+            if (strcmp(argv[2], LEVEL_NAMES[i]) == 0)
+            {
+                Log::setLevel((Log::Level)i);
+                return;
+            }
+        }
+    }
+
+    printf("Usage: log [dump|on|off|level debug|info|warning|error]\n");
+}
+
+void Log::start()
+{
+    static bool commandRegistered = false;
+    if (!commandRegistered)
+    {
+        commandRegistered = true;
+        Terminal::registerCommand({"log", "[dump|on|off|level]", "Deferred log statistics, history and filtering", log_command, nullptr});
+    }
+
+    isRunning = true;
+    if (xTaskCreate(log_task, "LogThread", configMINIMAL_STACK_SIZE * 2, NULL, (tskIDLE_PRIORITY + 1UL), &task) != pdPASS)
+        panic("Failed to create the LogThread task");
+}
+
+void Log::stop()
+{
+    isRunning = false;
+}
+
+Log::Stats Log::getStats()
+{
+    Stats stats = {};
+    for (const Ring &ring : rings)
+    {
+        stats.written += ring.written;
+        stats.dropped += ring.dropped;
+        stats.suppressed += ring.suppressed;
+    }
+    return stats;
+}
+
+void Log::setLevel(Level level)
+{
+    minLevel = level;
+}
+
+Log::Level Log::getLevel()
+{
+    return minLevel;
+}
+
+void Log::setOutputEnabled(bool enabled)
+{
+    outputEnabled = enabled;
+}
+
+void Log::dump()
+{
+    // the history is only written by the log task, a racing entry may print torn
+    uint32_t count = historyCount < Config::Logging::HISTORY_LENGTH ? historyCount : Config::Logging::HISTORY_LENGTH;
+    for (uint32_t i = historyCount - count; i < historyCount; i++)
+        print_entry(history[i % Config::Logging::HISTORY_LENGTH]);
+}
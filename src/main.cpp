@@ -3,10 +3,13 @@
 #include <string>
 #include <cstdarg>
 #include <cstring>
+#include <atomic>
+#include <math.h>
 
 // Kernel headers
 #include <FreeRTOS.h>
 #include <task.h>
+#include <semphr.h>
 
 // Config headers
 #include "config/timers.h"
@@ -33,9 +36,20 @@
 // Control
 #include "control/udpxbox.h"
 #include "control/driverstation.h"
+#include "control/linkloss.h"
+#include "control/trajectoryfollower.h"
+#include "control/telemetry.h"
 
 #include "communication.h"
+#include "ntpublisher.h"
 #include "terminal.h"
+#include "log.h"
+#include "flightrecorder.h"
+#include "inputcapture.h"
+#include "configstore.h"
+#include "bootprofile.h"
+#include "failsafe.h"
+#include "diagnostics.h"
 
 using namespace std::literals;
 
@@ -43,94 +57,369 @@ static Drivetrain *drivetrain;
 static Lights *lights;
 static Battery *battery;
 
-static void main_task(__unused void *params)
+struct LoopTiming
 {
-    battery = new Battery();
-    battery->startPingTimer();
+    uint32_t iterations;
+    uint32_t lastWorkUs;
+    uint32_t maxWorkUs;
+    uint32_t maxPeriodUs;
+    uint64_t totalWorkUs;
+};
 
-    lights = new Lights();
-    lights->setRingIndicatorPattern(Pattern::Pulse, Pattern::Pulse);
+static LoopTiming loopTiming;
+
+static void loop_command(int argc, char **argv, void *context)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        loopTiming = {};
+        return;
+    }
 
-    // Create wifi radio
+    printf("Main loop: %lu iterations, work last %luus avg %luus max %luus, max period %luus\n", (unsigned long)loopTiming.iterations,
+           (unsigned long)loopTiming.lastWorkUs, (unsigned long)(loopTiming.iterations > 0 ? loopTiming.totalWorkUs / loopTiming.iterations : 0),
+           (unsigned long)loopTiming.maxWorkUs, (unsigned long)loopTiming.maxPeriodUs);
+}
+
+static void spi_command(int argc, char **argv, void *context)
+{
+    const CommunicationStats &stats = ((Communication *)context)->getStats();
+    printf("SPI: %lu transfers, %lu failed, last %luus, max %luus\n", (unsigned long)stats.transfers, (unsigned long)stats.failures,
+           (unsigned long)stats.lastTransferUs, (unsigned long)stats.maxTransferUs);
+}
+
+static void linkloss_command(int argc, char **argv, void *context)
+{
+    static const char *PHASE_NAMES[] = {"connected", "hold", "decay", "stopped"};
+
+    LinkLossPolicy *linkLoss = (LinkLossPolicy *)context;
+    const LinkLossStats &stats = linkLoss->getStats();
+    printf("Link loss: %s, %lu holds, %lu decays, %lu stops, %lu recoveries\n", PHASE_NAMES[(int)linkLoss->getPhase()], (unsigned long)stats.holds,
+           (unsigned long)stats.decays, (unsigned long)stats.stops, (unsigned long)stats.recoveries);
+}
+
+static void nt_command(int argc, char **argv, void *context)
+{
+    const NTPublisherStats &stats = ((NTPublisher *)context)->getStats();
+    printf("NT: %lu flushes, %lu entries sent, last flush %luus, max %luus\n", (unsigned long)stats.flushes, (unsigned long)stats.entriesSent,
+           (unsigned long)stats.lastFlushUs, (unsigned long)stats.maxFlushUs);
+}
+
+static void telemetry_command(int argc, char **argv, void *context)
+{
+    const TelemetryStats &stats = ((Telemetry *)context)->getStats();
+    printf("Telemetry: %lu frames sent, %lu errors, port %d\n", (unsigned long)stats.sent, (unsigned long)stats.errors, Config::Network::TELEMETRY_PORT);
+}
+
+static void ds_command(int argc, char **argv, void *context)
+{
+    static const char *CLASS_NAMES[] = {"realtime", "normal", "bulk"};
+
+    printf("%-9s depth   max   queued dropped  wait avg/max us\n", "Class");
+    for (int i = 0; i < (int)DispatchClass::Count; i++)
+    {
+        DispatchStats stats = ((Driverstation *)context)->getStats((DispatchClass)i);
+        printf("%-9s %5lu %5lu %8lu %7lu  %lu/%lu\n", CLASS_NAMES[i], (unsigned long)stats.depth, (unsigned long)stats.maxDepth, (unsigned long)stats.queued,
+               (unsigned long)stats.dropped, stats.handled > 0 ? (unsigned long)(stats.totalWaitUs / stats.handled) : 0UL, (unsigned long)stats.maxWaitUs);
+    }
+}
+
+static uint16_t saturate_u16(uint64_t value)
+{
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+static int16_t to_milli(float value)
+{
+    float milli = value * 1000.0f;
+    return milli > 32767.0f ? 32767 : (milli < -32768.0f ? -32768 : (int16_t)milli);
+}
+
+/// @brief Everything that needs the radio, created by network_task and handed to the control
+/// loop in one step once complete
+struct NetworkServices
+{
+    Radio *radio;
+    NetworkTableInstance *nt;
+    NTPublisher *publisher;
+    Driverstation *driverstation;
+    UDPXbox *xbox;
+    Telemetry *telemetry;
+
+    int distances;
+    int pose;
+    int trajectoryError;
+    int batteryState;
+};
+
+static std::atomic<NetworkServices *> network{nullptr};
+static SemaphoreHandle_t driveReady;
+static TrajectoryFollower *follower;
+
+/// @brief Joins the wifi while main_task brings up the drive side, then starts the network
+/// services. A radio failure leaves the rover in local mode with the drivetrain stopped.
+static void network_task(__unused void *params)
+{
+    BootProfile::begin(BootProfile::Stage::Radio);
     Radio *radio = new Radio();
     if (!radio->isInitialized())
     {
-        printf("Error initializing radio\n");
+        printf("[BOOT] Error initializing radio, staying in local mode\n");
         delete radio;
-        delete lights;
-        delete battery;
         vTaskDelete(NULL);
         return;
     }
+    BootProfile::end(BootProfile::Stage::Radio);
+
+    NetworkServices *services = new NetworkServices();
+    services->radio = radio;
+
+    BootProfile::begin(BootProfile::Stage::NetworkTables);
+    services->nt = new NetworkTableInstance();
+    services->nt->startServer();
+    services->publisher = new NTPublisher(services->nt);
+    services->distances = services->publisher->add("SmartDashboard/Distance", 6, NTPriority::Normal);
+    services->pose = services->publisher->add("SmartDashboard/Pose", 3, NTPriority::High);
+    services->trajectoryError = services->publisher->add("SmartDashboard/TrajectoryError", 3, NTPriority::High);
+    services->batteryState = services->publisher->add("SmartDashboard/Battery", 3, NTPriority::Low);
+    BootProfile::end(BootProfile::Stage::NetworkTables);
+
+    // the driver station talks to the odometry, the follower and the drivetrain
+    xSemaphoreTake(driveReady, portMAX_DELAY);
+
+    BootProfile::begin(BootProfile::Stage::Driverstation);
+    services->driverstation = new Driverstation();
+    services->driverstation->setOdometry(drivetrain->getOdometry());
+    services->driverstation->setTrajectoryFollower(follower);
+    services->driverstation->setDrivetrain(drivetrain);
+    BootProfile::end(BootProfile::Stage::Driverstation);
+
+    BootProfile::begin(BootProfile::Stage::Xbox);
+    services->xbox = new UDPXbox();
+    BootProfile::end(BootProfile::Stage::Xbox);
+
+    BootProfile::begin(BootProfile::Stage::Telemetry);
+    services->telemetry = new Telemetry();
+    BootProfile::end(BootProfile::Stage::Telemetry);
+
+    Terminal::registerCommand({"ds", "", "Driverstation dispatch queues per priority class", ds_command, services->driverstation});
+    Terminal::registerCommand({"telemetry", "", "UDP telemetry broadcast statistics", telemetry_command, services->telemetry});
+    Terminal::registerCommand({"nt", "", "NetworkTables publisher statistics", nt_command, services->publisher});
+
+    network.store(services, std::memory_order_release);
+    BootProfile::reached(BootProfile::Milestone::NetworkReady);
+    lights->setRingIndicatorPattern(Pattern::Alt1, Pattern::Alt2);
+    printf("[BOOT] Network ready at %lu us (drive ready at %lu us)\n", (unsigned long)BootProfile::getMilestoneUs(BootProfile::Milestone::NetworkReady),
+           (unsigned long)BootProfile::getMilestoneUs(BootProfile::Milestone::DriveReady));
+    // every boot task is running by now, this is the peak of the boot overlap
+    printf("[BOOT] NetworkBoot stack headroom %lu words, heap minimum ever free %u bytes\n", (unsigned long)uxTaskGetStackHighWaterMark(NULL),
+           (unsigned)xPortGetMinimumEverFreeHeapSize());
+
+#if DEBUG_LEVEL > 0
+    // off the drive ready path
+    Diagnostics::kinematicsReport();
+    Diagnostics::velocityControllerReport();
+#endif
 
-    Terminal::start();
+    vTaskDelete(NULL);
+}
+
+static void main_task(__unused void *params)
+{
+    // the radio join takes seconds and depends on nothing below, start it first
+    driveReady = xSemaphoreCreateBinary();
+    // only constructors run on it, the stack is freed again once the network is up
+    if (xTaskCreate(network_task, "NetworkBoot", configMINIMAL_STACK_SIZE * 5, NULL, (tskIDLE_PRIORITY + 3UL), NULL) != pdPASS)
+        panic("Failed to create the NetworkBoot task");
+
+    BootProfile::begin(BootProfile::Stage::Battery);
+    battery = new Battery();
+    battery->startPingTimer();
+    BootProfile::end(BootProfile::Stage::Battery);
 
-    NetworkTableInstance *nt = new NetworkTableInstance();
-    nt->startServer();
+    BootProfile::begin(BootProfile::Stage::Lights);
+    lights = new Lights();
+    lights->setRingIndicatorPattern(Pattern::Pulse, Pattern::Pulse);
+    BootProfile::end(BootProfile::Stage::Lights);
+
+    BootProfile::begin(BootProfile::Stage::Services);
+    Terminal::start();
+    Log::start();
+    InputCapture::init();
+    BootProfile::end(BootProfile::Stage::Services);
 
     // Initialize and create subsystems
+    BootProfile::begin(BootProfile::Stage::Drivetrain);
     drivetrain = new Drivetrain();
+    drivetrain->stop();
+    BootProfile::end(BootProfile::Stage::Drivetrain);
 
-    lights->setRingIndicatorPattern(Pattern::Alt1, Pattern::Alt2);
-
-    Driverstation *driverstation = new Driverstation();
-    UDPXbox *xbox = new UDPXbox();
+    BootProfile::begin(BootProfile::Stage::Control);
+    follower = new TrajectoryFollower();
+    LinkLossPolicy *linkLoss = new LinkLossPolicy(UDPXbox::MAX_PACKET_INTERVAL_US, ConfigStore::get().linkHoldUs, ConfigStore::get().linkDecayUs, Config::Control::LINK_DECAY_PROFILE);
+    BootProfile::end(BootProfile::Stage::Control);
 
+    BootProfile::begin(BootProfile::Stage::Communication);
     Communication *comm = new Communication(true);
+    BootProfile::end(BootProfile::Stage::Communication);
+
+    Terminal::registerCommand({"loop", "[reset]", "Main control loop timing", loop_command, nullptr});
+    Terminal::registerCommand({"spi", "", "Sensor board SPI link statistics", spi_command, comm});
+    Terminal::registerCommand({"linkloss", "", "Xbox link loss phase and per-phase counters", linkloss_command, linkLoss});
+    Terminal::registerTunable({"ramsete.b", Terminal::TunableType::Float, &follower->getGains().b});
+    Terminal::registerTunable({"ramsete.zeta", Terminal::TunableType::Float, &follower->getGains().zeta});
 
-    NTEntry distances = NTEntry(nt, "SmartDashboard/Distance", NTDataValue(std::vector<float>{0, 0, 0, 0, 0, 0}));
+    Failsafe::start(drivetrain->getOutputs(), drivetrain->getDriveOutput());
+    BootProfile::reached(BootProfile::Milestone::DriveReady);
+    xSemaphoreGive(driveReady);
 
-    absolute_time_t lastFlush = get_absolute_time();
+    float overrideDeadband = ConfigStore::get().trajectoryOverrideDeadband;
+    absolute_time_t lastPosePublish = get_absolute_time();
+    uint64_t loopStart = time_us_64();
     while (true)
     {
+        uint64_t loopEnd = time_us_64();
+        loopTiming.lastWorkUs = (uint32_t)(loopEnd - loopStart);
+        loopTiming.totalWorkUs += loopTiming.lastWorkUs;
+        if (loopTiming.lastWorkUs > loopTiming.maxWorkUs)
+            loopTiming.maxWorkUs = loopTiming.lastWorkUs;
+        loopTiming.iterations++;
+
         vTaskDelay(pdMS_TO_TICKS(20));
-        if (xbox->isConnected())
+        Failsafe::feed();
+
+        uint64_t now = time_us_64();
+        if (now - loopStart > loopTiming.maxPeriodUs)
+            loopTiming.maxPeriodUs = (uint32_t)(now - loopStart);
+
+        FlightRecord record{};
+        record.timeUs = (uint32_t)now;
+        record.periodUs = saturate_u16(now - loopStart);
+        loopStart = now;
+
+        // null until network_task is done, the loop runs local only (stopped, sense board, recorder) meanwhile
+        NetworkServices *services = network.load(std::memory_order_acquire);
+        UDPXbox *xbox = services != nullptr ? services->xbox : nullptr;
+
+        battery->update();
+        drivetrain->setVoltageCompensation(battery->getCompensation());
+        record.batteryMillivolts = saturate_u16((uint64_t)(battery->getVoltage() * 1000.0f));
+        if (battery->isBrownout())
+            FlightRecorder::freeze(FreezeReason::Brownout);
+
+        // driver input always wins over a running trajectory
+        if (xbox != nullptr && xbox->isConnected() && (fabsf(xbox->getForward().meters()) > overrideDeadband ||
+                                                       fabsf(xbox->getRotation().radians()) > overrideDeadband))
         {
-            drivetrain->drive(xbox->getForward(), xbox->getRotation());
+            follower->cancel();
+        }
+
+        float trajectoryForward, trajectoryRotation;
+        if (follower->update(drivetrain->getOdometry()->getPose().pose, time_us_64(), trajectoryForward, trajectoryRotation))
+        {
+            drivetrain->drive(Units<float>::meters(trajectoryForward), Units<float>::radians(trajectoryRotation));
             lights->setStatusLedPattern(Pattern::Blink);
+            record.source = RecordSource::Trajectory;
+        }
+        else if (xbox != nullptr && linkLoss->update(xbox->getPacketAge(), xbox->getForward(), xbox->getRotation()))
+        {
+            drivetrain->drive(linkLoss->getForward(), linkLoss->getRotation());
+            lights->setStatusLedPattern(linkLoss->getPhase() == LinkLossPhase::Connected ? Pattern::Blink : Pattern::Pulse);
+            record.source = RecordSource::Xbox;
         }
         else
         {
             drivetrain->stop();
             lights->setStatusLedPattern(Pattern::On);
+            record.source = RecordSource::Stopped;
         }
 
+        if (record.source != RecordSource::Stopped)
+            BootProfile::reached(BootProfile::Milestone::FirstCommand);
+
+        record.forward = xbox != nullptr ? to_milli(xbox->getForward().meters()) : 0;
+        record.rotation = xbox != nullptr ? to_milli(xbox->getRotation().radians()) : 0;
+        record.leftTarget = to_milli(drivetrain->getLeftTarget().toFloat());
+        record.rightTarget = to_milli(drivetrain->getRightTarget().toFloat());
+        record.leftOutput = to_milli(drivetrain->getLeftOutput().toFloat());
+        record.rightOutput = to_milli(drivetrain->getRightOutput().toFloat());
+        record.linkPhase = (uint8_t)linkLoss->getPhase();
+
+        uint64_t stageStart = time_us_64();
+        record.controlUs = saturate_u16(stageStart - now);
+
         CommunicationControl control{};
 
         CommunicationStatus status{};
         CommunicationDistanceSensors sensors{};
+        bool sensorsValid = false;
         if (!comm->read(control, &status, &sensors))
         {
-            printf("[COMM] Error reading data\n");
+            LOG(Log::Level::Warning, "[COMM] Error reading data");
         }
         else if (status.version != 0xBADC0DE5 || !status.running)
         {
-            printf("[COMM] Invalid status %#010x, %#04x\n", status.version, status.running ? 0xFF : 0x00);
+            LOG(Log::Level::Warning, "[COMM] Invalid status %#010x, %#04x", status.version, status.running ? 0xFF : 0x00);
         }
         else
         {
-            distances.set(NTDataValue(std::vector<float>{sensors.distance0, sensors.distance1, sensors.distance2, sensors.distance3, sensors.distance4, sensors.distance5}));
+            if (services != nullptr)
+                services->publisher->set(services->distances, {sensors.distance0, sensors.distance1, sensors.distance2, sensors.distance3, sensors.distance4, sensors.distance5});
+            sensorsValid = true;
         }
 
-        if (absolute_time_diff_us(lastFlush, get_absolute_time()) > 100 * 1000)
+        const float sensorDistances[] = {sensors.distance0, sensors.distance1, sensors.distance2, sensors.distance3, sensors.distance4, sensors.distance5};
+        for (int i = 0; i < 6; i++)
+            record.distances[i] = sensorsValid ? saturate_u16((uint64_t)(sensorDistances[i] > 0 ? sensorDistances[i] * 1000.0f : 0)) : 0xFFFF;
+
+        uint64_t commEnd = time_us_64();
+        record.commUs = saturate_u16(commEnd - stageStart);
+
+        if (services != nullptr && absolute_time_diff_us(lastPosePublish, get_absolute_time()) > Config::Network::UPDATE_TIME_US)
         {
-            lastFlush = get_absolute_time();
-            nt->flush();
+            lastPosePublish = get_absolute_time();
+            TimestampedPose current = drivetrain->getOdometry()->getPose();
+            services->publisher->set(services->pose, {current.pose.x.toFloat(), current.pose.y.toFloat(), current.pose.heading.toFloat()});
+            services->driverstation->publishPose();
+
+            services->publisher->set(services->batteryState, {battery->getVoltage(), battery->getSag(), battery->isBrownout() ? 1.0f : 0.0f});
+
+            TrajectoryTracking tracking = follower->getTracking();
+            if (tracking.active)
+            {
+                services->publisher->set(services->trajectoryError, {tracking.alongError, tracking.crossError, tracking.headingError});
+                services->driverstation->publishTrajectoryStatus();
+            }
         }
-    }
 
-    delete comm;
+        record.publishUs = saturate_u16(time_us_64() - commEnd);
+        FlightRecorder::record(record);
+        if (services != nullptr)
+            services->telemetry->post(drivetrain->getOdometry()->getPose().pose, record);
+    }
 
+    Log::stop();
     Terminal::stop();
 
-    delete xbox;
-    delete driverstation;
+    NetworkServices *services = network.exchange(nullptr);
+    if (services != nullptr)
+    {
+        delete services->telemetry;
+        delete services->xbox;
+        delete services->driverstation;
+        delete services->publisher;
+        services->nt->close();
+        delete services->nt;
+        services->radio->deinit();
+        delete services->radio;
+        delete services;
+    }
+
+    delete comm;
+    delete linkLoss;
+    delete follower;
 
     // Deinitialize subsystems
-    nt->close();
-    delete nt;
-    radio->deinit();
-    delete radio;
     delete drivetrain;
     delete lights;
     delete battery;
@@ -140,11 +429,16 @@ static void main_task(__unused void *params)
 
 int main()
 {
+    BootProfile::begin(BootProfile::Stage::Startup);
     stdio_init_all();
     sleep_us(64);
 
     Config::init_timers();
     Temperature::init();
+    FlightRecorder::init();
+    Failsafe::init();
+    ConfigStore::init();
+    BootProfile::init();
 
 #ifdef FREQUENCY_DEBUG
     double freq;
@@ -160,11 +454,17 @@ int main()
     }
 #endif
 
+#ifdef ROVER_BENCHMARK
+    Diagnostics::benchmarkReport();
+#endif
+
     printf("[BOOT] Creating MainThread task\n");
     TaskHandle_t task;
-    xTaskCreate(main_task, "MainThread", configMAIN_THREAD_STACK_SIZE, NULL, (tskIDLE_PRIORITY + 4UL), &task);
+    if (xTaskCreate(main_task, "MainThread", configMAIN_THREAD_STACK_SIZE, NULL, (tskIDLE_PRIORITY + 4UL), &task) != pdPASS)
+        panic("Failed to create the MainThread task");
 
     printf("[BOOT] Starting task scheduler\n");
+    BootProfile::end(BootProfile::Stage::Startup);
     vTaskStartScheduler();
 
     Temperature::deinit();
@@ -174,6 +474,9 @@ int main()
 
 extern "C" void rtos_panic(const char *fmt, ...)
 {
+    Failsafe::trip(FailsafeCause::Panic);
+    FlightRecorder::freeze(FreezeReason::Panic);
+
     puts("\n*** PANIC ***\n");
     if (fmt)
     {
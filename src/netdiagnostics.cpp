@@ -0,0 +1,130 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Hardware headers
+#include <pico/time.h>
+
+// Libraries
+#include <lwip/sockets.h>
+#include <lwip/netif.h>
+#include <lwip/tcpip.h>
+#include <udpsocket.h>
+
+#include "control/rawudpsocket.h"
+#include "diagnostics.h"
+
+#if LWIP_NETIF_LOOPBACK
+static constexpr int UDP_BENCH_RAW_PORT = 5010;
+static constexpr int UDP_BENCH_SOCKET_PORT = 5011;
+static constexpr int UDP_BENCH_PACKETS = 200;
+static constexpr uint32_t UDP_BENCH_TIMEOUT_US = 20000;
+
+struct LatencyStats
+{
+    volatile uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+};
+
+/// @brief Called from either receive path with the send timestamp as payload
+static void record_latency(LatencyStats *stats, const void *data, size_t length)
+{
+    uint32_t now = time_us_32();
+    uint32_t sent;
+    if (length < sizeof(sent))
+        return;
+    memcpy(&sent, data, sizeof(sent));
+
+    uint32_t latency = now - sent;
+    if (latency < stats->min)
+        stats->min = latency;
+    if (latency > stats->max)
+        stats->max = latency;
+    stats->total += latency;
+    stats->count = stats->count + 1;
+}
+
+/// @brief Sends timestamped datagrams to our own address one at a time and waits for each to arrive
+static void run_latency(const char *name, int sender, const ip4_addr_t &address, int port, LatencyStats &stats)
+{
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_port = lwip_htons(port);
+    destination.sin_addr.s_addr = ip4_addr_get_u32(&address);
+
+    stats = {0, UINT32_MAX, 0, 0};
+    int lost = 0;
+    for (int i = 0; i < UDP_BENCH_PACKETS; i++)
+    {
+        uint32_t expected = stats.count + 1;
+        uint32_t sent = time_us_32();
+        lwip_sendto(sender, &sent, sizeof(sent), 0, (sockaddr *)&destination, sizeof(destination));
+
+        while (stats.count < expected && time_us_32() - sent < UDP_BENCH_TIMEOUT_US)
+            vTaskDelay(1);
+        if (stats.count < expected)
+            lost++;
+    }
+
+    if (stats.count == 0)
+    {
+        printf("[UDP] %s: no datagrams received\n", name);
+        return;
+    }
+    printf("[UDP] %s: min %lu us, avg %lu us, max %lu us (%lu received, %i lost)\n", name, (unsigned long)stats.min,
+           (unsigned long)(stats.total / stats.count), (unsigned long)stats.max, (unsigned long)stats.count, lost);
+}
+
+void Diagnostics::udpLatencyReport()
+{
+    if (netif_default == nullptr || ip4_addr_isany_val(*netif_ip4_addr(netif_default)))
+    {
+        printf("[UDP] No network address\n");
+        return;
+    }
+    ip4_addr_t address = *netif_ip4_addr(netif_default);
+
+    int sender = lwip_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sender < 0)
+    {
+        printf("[UDP] Error creating socket\n");
+        return;
+    }
+
+    LatencyStats rawStats;
+    RawUdpSocket *raw = new RawUdpSocket(UDP_BENCH_RAW_PORT);
+    raw->callbackArgs = &rawStats;
+    raw->receiveCallback = [](RawUdpSocket *socket, const RawDatagram *datagram, void *args)
+    {
+        record_latency((LatencyStats *)args, datagram->data, datagram->length);
+    };
+    if (raw->isBound())
+        run_latency("raw api", sender, address, UDP_BENCH_RAW_PORT, rawStats);
+    delete raw;
+
+    LatencyStats socketStats;
+    UdpSocket *socket = new UdpSocket(UDP_BENCH_SOCKET_PORT);
+    socket->callbackArgs = &socketStats;
+    socket->receiveCallback = [](UdpSocket *socket, Datagram *datagram, void *args)
+    {
+        record_latency((LatencyStats *)args, datagram->data, datagram->length);
+    };
+    run_latency("socket api", sender, address, UDP_BENCH_SOCKET_PORT, socketStats);
+    socket->deinit();
+    delete socket;
+
+    lwip_close(sender);
+}
+#else
+void Diagnostics::udpLatencyReport()
+{
+    printf("[UDP] Loopback is disabled in this build (ROVER_PROFILE release)\n");
+}
+#endif
@@ -0,0 +1,140 @@
+// Standard headers
+#include <stdlib.h>
+#include <vector>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "ntpublisher.h"
+
+void nt_publisher_task(void *pv_publisher)
+{
+    NTPublisher *publisher = (NTPublisher *)pv_publisher;
+
+    TickType_t lastFlush = xTaskGetTickCount();
+    while (publisher->running)
+    {
+        // woken early by high priority changes, otherwise runs at the normal period
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(Config::Network::NT_NORMAL_PERIOD_MS));
+
+        // coalesce bursts of changes into one flush
+        vTaskDelayUntil(&lastFlush, pdMS_TO_TICKS(Config::Network::NT_MIN_FLUSH_INTERVAL_MS));
+        lastFlush = xTaskGetTickCount();
+
+        publisher->flush();
+    }
+
+    publisher->exited = true;
+    vTaskDelete(NULL);
+}
+
+NTPublisher::NTPublisher(NetworkTableInstance *nt) : nt(nt), slotCount(0), running(true), exited(false), lastNormalUs(0), lastLowUs(0), stats({})
+{
+    critical_section_init(&lock);
+    if (xTaskCreate(nt_publisher_task, "NTPublisherThread", configMINIMAL_STACK_SIZE * 4, this, (tskIDLE_PRIORITY + 2UL), &task) != pdPASS)
+        panic("Failed to create the NTPublisherThread task");
+}
+
+NTPublisher::~NTPublisher()
+{
+    running = false;
+    xTaskNotifyGive(task);
+    while (!exited)
+        vTaskDelay(pdMS_TO_TICKS(Config::Network::NT_MIN_FLUSH_INTERVAL_MS));
+
+    for (int i = 0; i < slotCount; i++)
+        delete slots[i].entry;
+    critical_section_deinit(&lock);
+}
+
+int NTPublisher::add(const char *name, int valueCount, NTPriority priority)
+{
+    if (slotCount >= MAX_ENTRIES || valueCount > MAX_VALUES)
+        return -1;
+
+    Slot &slot = slots[slotCount];
+    slot.entry = new NTEntry(nt, name, NTDataValue(std::vector<float>(valueCount, 0.0f)));
+    slot.priority = priority;
+    slot.count = valueCount;
+    slot.dirty = false;
+    for (float &value : slot.values)
+        value = 0;
+
+    return slotCount++;
+}
+
+void NTPublisher::set(int handle, std::initializer_list<float> values)
+{
+    if (handle < 0 || handle >= slotCount)
+        return;
+
+    Slot &slot = slots[handle];
+    bool changed = false;
+
+    critical_section_enter_blocking(&lock);
+    int i = 0;
+    for (float value : values)
+    {
+        if (i >= slot.count)
+            break;
+        if (slot.values[i] != value)
+        {
+            slot.values[i] = value;
+            changed = true;
+        }
+        i++;
+    }
+    slot.dirty = slot.dirty || changed;
+    critical_section_exit(&lock);
+
+    if (changed && slot.priority == NTPriority::High)
+        xTaskNotifyGive(task);
+}
+
+void NTPublisher::flush()
+{
+    uint64_t start = time_us_64();
+    bool normalDue = start - lastNormalUs >= Config::Network::NT_NORMAL_PERIOD_MS * 1000;
+    bool lowDue = start - lastLowUs >= Config::Network::NT_LOW_PERIOD_MS * 1000;
+    if (normalDue)
+        lastNormalUs = start;
+    if (lowDue)
+        lastLowUs = start;
+
+    uint32_t sent = 0;
+    for (int i = 0; i < slotCount; i++)
+    {
+        Slot &slot = slots[i];
+        bool due = slot.priority == NTPriority::High || (slot.priority == NTPriority::Normal ? normalDue : lowDue);
+        if (!due || !slot.dirty)
+            continue;
+
+        float values[MAX_VALUES];
+        critical_section_enter_blocking(&lock);
+        for (int v = 0; v < slot.count; v++)
+            values[v] = slot.values[v];
+        slot.dirty = false;
+        critical_section_exit(&lock);
+
+        slot.entry->set(NTDataValue(std::vector<float>(values, values + slot.count)));
+        sent++;
+    }
+
+    if (sent == 0)
+        return;
+
+    nt->flush();
+
+    stats.flushes++;
+    stats.entriesSent += sent;
+    stats.lastFlushUs = (uint32_t)(time_us_64() - start);
+    if (stats.lastFlushUs > stats.maxFlushUs)
+        stats.maxFlushUs = stats.lastFlushUs;
+}
@@ -1,18 +1,131 @@
+// Hardware headers
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+
 #include "subsystems/battery.h"
 
 #include "config/options.h"
 
-Battery::Battery() : pingTimerRunning(false), pingPin(Config::Battery::PING_PIN)
+// ring writes need the buffer aligned to its size in bytes
+static uint16_t samples[Battery::SAMPLE_BUFFER_LENGTH] __attribute__((aligned(Battery::SAMPLE_BUFFER_LENGTH * sizeof(uint16_t))));
+
+static constexpr uint64_t RING_FILL_US = (uint64_t)Battery::SAMPLE_BUFFER_LENGTH * 1000000 / Config::Battery::SAMPLE_RATE_HZ;
+
+Battery::Battery() : pingTimerRunning(false),
+                     pingPin(Config::Battery::PING_PIN),
+                     sampleReload(SAMPLE_BUFFER_LENGTH),
+                     voltage(0.0f),
+                     restingVoltage(0.0f),
+                     valid(false),
+                     brownout(false),
+                     compensation(q16_16::fromInt(1)),
+                     lastUpdate(0),
+                     readyUs(0)
 {
     gpio_init(pingPin);
     gpio_set_dir(pingPin, true);
     gpio_put(pingPin, true);
+
+    if constexpr (!Config::Battery::ENABLED)
+        return;
+
+    adc_init();
+    adc_gpio_init(Config::Battery::SENSE_PIN);
+    adc_select_input(Config::Battery::SENSE_ADC_INPUT);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(48000000.0f / Config::Battery::SAMPLE_RATE_HZ - 1);
+
+    sampleDma = dma_claim_unused_channel(true);
+    controlDma = dma_claim_unused_channel(true);
+
+    // The sample channel fills the ring once per run and chains to the control channel,
+    // which rewrites its transfer count and retriggers it. Sampling never needs the CPU.
+    dma_channel_config control = dma_channel_get_default_config(controlDma);
+    channel_config_set_transfer_data_size(&control, DMA_SIZE_32);
+    channel_config_set_read_increment(&control, false);
+    channel_config_set_write_increment(&control, false);
+    dma_channel_configure(controlDma, &control, &dma_hw->ch[sampleDma].al1_transfer_count_trig, &sampleReload, 1, false);
+
+    dma_channel_config sample = dma_channel_get_default_config(sampleDma);
+    channel_config_set_transfer_data_size(&sample, DMA_SIZE_16);
+    channel_config_set_read_increment(&sample, false);
+    channel_config_set_write_increment(&sample, true);
+    channel_config_set_ring(&sample, true, SAMPLE_BUFFER_BITS + 1);
+    channel_config_set_dreq(&sample, DREQ_ADC);
+    channel_config_set_chain_to(&sample, controlDma);
+    dma_channel_configure(sampleDma, &sample, samples, &adc_hw->fifo, SAMPLE_BUFFER_LENGTH, true);
+
+    adc_run(true);
+    readyUs = time_us_64() + RING_FILL_US;
 }
 
 Battery::~Battery()
 {
     stopPingTimer();
     gpio_deinit(pingPin);
+
+    if constexpr (!Config::Battery::ENABLED)
+        return;
+
+    adc_run(false);
+
+    // unchain first so aborting the sample channel cannot retrigger it
+    dma_channel_config sample = dma_get_channel_config(sampleDma);
+    channel_config_set_chain_to(&sample, sampleDma);
+    dma_channel_set_config(sampleDma, &sample, false);
+    dma_channel_abort(controlDma);
+    dma_channel_abort(sampleDma);
+    dma_channel_unclaim(controlDma);
+    dma_channel_unclaim(sampleDma);
+    adc_fifo_drain();
+}
+
+float Battery::readAverage(uint count)
+{
+    // the newest sample sits right before the channel's write address
+    uint newest = ((uintptr_t)dma_hw->ch[sampleDma].write_addr - (uintptr_t)samples) / sizeof(uint16_t);
+
+    uint32_t sum = 0;
+    for (uint i = 1; i <= count; i++)
+        sum += samples[(newest - i) & (SAMPLE_BUFFER_LENGTH - 1)];
+
+    return (float)sum / count * (Config::Battery::ADC_REFERENCE / 4096.0f) * Config::Battery::SENSE_DIVIDER;
+}
+
+void Battery::update()
+{
+    uint64_t now = time_us_64();
+    if (!Config::Battery::ENABLED || now < readyUs)
+        return;
+
+    voltage = readAverage(Config::Battery::FAST_WINDOW);
+
+    if (lastUpdate == 0)
+    {
+        restingVoltage = readAverage(SAMPLE_BUFFER_LENGTH);
+    }
+    else
+    {
+        float alpha = (float)(now - lastUpdate) / (Config::Battery::SLOW_TIME_CONSTANT_S * 1000000.0f);
+        restingVoltage += (voltage - restingVoltage) * (alpha < 1.0f ? alpha : 1.0f);
+    }
+    lastUpdate = now;
+
+    valid = voltage >= Config::Battery::MIN_SENSE_VOLTAGE && voltage <= Config::Battery::MAX_SENSE_VOLTAGE;
+    if (!valid)
+    {
+        brownout = false;
+        compensation = q16_16::fromInt(1);
+        return;
+    }
+
+    if (brownout)
+        brownout = voltage < Config::Battery::BROWNOUT_VOLTAGE + Config::Battery::BROWNOUT_HYSTERESIS;
+    else
+        brownout = voltage < Config::Battery::BROWNOUT_VOLTAGE;
+
+    float scale = Config::Battery::NOMINAL_VOLTAGE / voltage;
+    compensation = q16_16::fromFloat(scale < Config::Battery::MAX_COMPENSATION ? scale : Config::Battery::MAX_COMPENSATION);
 }
 
 void Battery::startPingTimer()
@@ -0,0 +1,93 @@
+// Standard headers
+#include <stdlib.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/time.h>
+
+// Kernel headers
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Config headers
+#include "config/options.h"
+#include "configstore.h"
+
+#include "subsystems/driveoutput.h"
+#include "subsystems/drivetrain.h"
+#include "subsystems/odometry.h"
+
+void drive_output_task(void *pv_output)
+{
+    DriveOutput *output = (DriveOutput *)pv_output;
+
+    TickType_t lastWake = xTaskGetTickCount();
+    while (output->isRunning())
+    {
+        output->update();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(Config::Drivetrain::OUTPUT_PERIOD_MS));
+    }
+
+    output->exited = true;
+    vTaskDelete(NULL);
+}
+
+DriveOutput::DriveOutput(MotorOutputs *outputs, DifferentialModule *left, DifferentialModule *right, Odometry *odometry) : outputs(outputs), left(left), right(right), odometry(odometry), running(true), exited(false), mailboxSequence(0), targets({}), leftOutput(), rightOutput(),
+                                                                                                                           accelerationStep(q16_16::fromFloat(ConfigStore::get().maxAcceleration * Config::Drivetrain::OUTPUT_PERIOD_MS / 1000.0f)),
+                                                                                                                           decelerationStep(q16_16::fromFloat(ConfigStore::get().maxDeceleration * Config::Drivetrain::OUTPUT_PERIOD_MS / 1000.0f)),
+                                                                                                                           ticks(0)
+{
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+    BaseType_t created = xTaskCreateAffinitySet(drive_output_task, "DriveOutputThread", configMINIMAL_STACK_SIZE, this, (tskIDLE_PRIORITY + 5UL), 1 << Config::Drivetrain::OUTPUT_CORE, &task);
+#else
+    BaseType_t created = xTaskCreate(drive_output_task, "DriveOutputThread", configMINIMAL_STACK_SIZE, this, (tskIDLE_PRIORITY + 5UL), &task);
+#endif
+    if (created != pdPASS)
+        panic("Failed to create the DriveOutputThread task");
+}
+
+DriveOutput::~DriveOutput()
+{
+    running = false;
+
+    // the task touches the modules every period, wait for it to exit before they go away
+    while (!exited)
+        vTaskDelay(pdMS_TO_TICKS(Config::Drivetrain::OUTPUT_PERIOD_MS));
+}
+
+void DriveOutput::setTargets(q16_16 left, q16_16 right)
+{
+    mailbox.post({left, right, false});
+}
+
+void DriveOutput::stop()
+{
+    mailbox.post({q16_16(), q16_16(), true});
+}
+
+q16_16 DriveOutput::ramp(q16_16 current, q16_16 target)
+{
+    // speeding up (away from zero) is limited by acceleration, everything else by deceleration
+    bool accelerating = target.abs() > current.abs() && (current == q16_16() || (current < q16_16()) == (target < q16_16()));
+    q16_16 step = accelerating ? accelerationStep : decelerationStep;
+
+    if (target > current)
+        return target - current > step ? current + step : target;
+    else
+        return current - target > step ? current - step : target;
+}
+
+void DriveOutput::update()
+{
+    mailbox.read(targets, mailboxSequence);
+
+    leftOutput = targets.immediate ? targets.left : ramp(leftOutput, targets.left);
+    rightOutput = targets.immediate ? targets.right : ramp(rightOutput, targets.right);
+
+    left->setDesiredState(leftOutput);
+    right->setDesiredState(rightOutput);
+    outputs->commit(); // skipped when no level changed
+
+    odometry->update(left->getVelocity(), right->getVelocity(), time_us_64());
+    ticks = ticks + 1;
+}
@@ -2,72 +2,153 @@
 #include <stdlib.h>
 
 // Libraries
-#include <motor.h>
 #include <math/units.h>
 #include <kinematics/differentialdrive.h>
+#include "math/fixedunits.h"
+#include "kinematics/fixeddifferentialdrive.h"
 
 // Config headers
 #include "config/options.h"
+#include "configstore.h"
 
 #include "subsystems/drivetrain.h"
+#include "subsystems/motoroutputs.h"
+#include "subsystems/driveoutput.h"
+#include "subsystems/encoder.h"
+#include "control/velocitycontroller.h"
 
-DifferentialModule::DifferentialModule(const ModuleConfig &config) : motorFront(new Motor(config.frontPinCW, config.frontPinCCW)),
-                                                                     motorCenter(new Motor(config.centerPinCW, config.centerPinCCW)),
-                                                                     motorBack(new Motor(config.backPinCW, config.backPinCCW)),
-                                                                     wheelDiameter(config.wheelDiameter)
+DifferentialModule::DifferentialModule(const ModuleConfig &config, MotorOutputs *outputs, MotorIndex front, MotorIndex center, MotorIndex back) : outputs(outputs),
+                                                                                                                                                motorFront(front),
+                                                                                                                                                motorCenter(center),
+                                                                                                                                                motorBack(back),
+                                                                                                                                                controller(ConfigStore::get().velocityGains(), Config::Drivetrain::OUTPUT_PERIOD_FIXED),
+                                                                                                                                                sensor(nullptr),
+                                                                                                                                                velocity(),
+                                                                                                                                                wheelDiameter(config.wheelDiameter)
 {
+    if (config.hasEncoder())
+    {
+        sensor = new QuadratureEncoder(config.encoderPinA, config.encoderPinB, config.encoderCountsPerRevolution, config.wheelDiameter, Config::Drivetrain::OUTPUT_PERIOD_MS / 1000.0f);
+    }
+
     stop();
 }
 
 DifferentialModule::~DifferentialModule()
 {
     stop();
-    delete motorFront;
-    delete motorCenter;
-    delete motorBack;
+    delete sensor;
+}
+
+void DifferentialModule::setVelocitySensor(VelocitySensor *sensor)
+{
+    delete this->sensor;
+    this->sensor = sensor;
+    controller.reset();
+}
+
+void DifferentialModule::stage(q16_16 duty)
+{
+    outputs->stage(motorFront, duty);
+    outputs->stage(motorCenter, duty);
+    outputs->stage(motorBack, duty);
 }
 
 void DifferentialModule::setDesiredState(Units<float> speed)
 {
-    motorFront->set(speed.meters());
-    motorCenter->set(speed.meters());
-    motorBack->set(speed.meters());
+    setDesiredState(q16_16::fromFloat(speed.meters()));
+}
+
+void DifferentialModule::setDesiredState(q16_16 speed)
+{
+    q16_16 measured;
+    if (sensor != nullptr && sensor->read(measured))
+    {
+        velocity = measured;
+        stage(controller.calculate(speed, measured));
+    }
+    else
+    {
+        velocity = speed;
+        stage(controller.calculate(speed));
+    }
 }
 
 void DifferentialModule::stop()
 {
-    motorFront->set(0);
-    motorCenter->set(0);
-    motorBack->set(0);
+    controller.reset();
+    velocity = q16_16();
+    stage(q16_16());
 }
 
-Drivetrain::Drivetrain() : kinematics(new DifferentialDriveKinematics(Config::Drivetrain::ROBOT_WHEEL_DISTANCE)),
-                           left(new DifferentialModule(Config::Drivetrain::LEFT_CONSTANTS)),
-                           right(new DifferentialModule(Config::Drivetrain::RIGHT_CONSTANTS))
+Drivetrain::Drivetrain() : kinematics(new DifferentialDriveKinematics(Units<float>::meters(ConfigStore::get().wheelDistance))),
+                           fixedKinematics(FixedUnitsQ16::meters(ConfigStore::get().wheelDistance)),
+                           maxSpeed(Units<float>::meters(ConfigStore::get().maxSpeed)),
+                           maxSpeedFixed(q16_16::fromFloat(ConfigStore::get().maxSpeed)),
+                           outputs(new MotorOutputs(Config::Drivetrain::LEFT_CONSTANTS, Config::Drivetrain::RIGHT_CONSTANTS)),
+                           left(new DifferentialModule(Config::Drivetrain::LEFT_CONSTANTS, outputs, MotorIndex::LeftFront, MotorIndex::LeftCenter, MotorIndex::LeftBack)),
+                           right(new DifferentialModule(Config::Drivetrain::RIGHT_CONSTANTS, outputs, MotorIndex::RightFront, MotorIndex::RightCenter, MotorIndex::RightBack)),
+                           odometry(new Odometry(fixedKinematics)),
+                           output(new DriveOutput(outputs, left, right, odometry)),
+                           leftTarget(),
+                           rightTarget(),
+                           held(false)
 {
     stop();
 }
 
 Drivetrain::~Drivetrain()
 {
-    stop();
+    delete output;
+    outputs->stop();
+    delete odometry;
     delete kinematics;
     delete left;
     delete right;
+    delete outputs;
 }
 
 void Drivetrain::drive(Units<float> speed, Units<float> rotation)
 {
+    if (held)
+    {
+        stop();
+        return;
+    }
+
+    if constexpr (Config::Drivetrain::FIXED_POINT_KINEMATICS)
+    {
+        drive(FixedUnitsQ16::fromMeters(speed), FixedUnitsQ16::fromRadians(rotation));
+        return;
+    }
+
     DifferentialDriveWheelSpeeds wheelSpeeds = kinematics->toWheelSpeeds(ChassisSpeeds<float>(speed, Units<float>::meters(0), rotation));
-    wheelSpeeds.normalize(Config::Drivetrain::ROBOT_MAX_SPEED);
+    wheelSpeeds.normalize(maxSpeed);
 
-    left->setDesiredState(wheelSpeeds.left);
-    right->setDesiredState(wheelSpeeds.right);
+    leftTarget = q16_16::fromFloat(wheelSpeeds.left.meters());
+    rightTarget = q16_16::fromFloat(wheelSpeeds.right.meters());
+    output->setTargets(leftTarget, rightTarget);
+}
+
+void Drivetrain::drive(FixedUnitsQ16 speed, FixedUnitsQ16 rotation)
+{
+    if (held)
+    {
+        stop();
+        return;
+    }
+
+    FixedDifferentialDriveWheelSpeeds<16> wheelSpeeds = fixedKinematics.toWheelSpeeds({speed.meters(), q16_16(), rotation.radians()});
+    wheelSpeeds.normalize(maxSpeedFixed);
+
+    leftTarget = wheelSpeeds.left;
+    rightTarget = wheelSpeeds.right;
+    output->setTargets(leftTarget, rightTarget);
 }
 
 void Drivetrain::stop()
 {
-    drive(Units<float>::meters(0), Units<float>::radians(0));
-    left->stop();
-    right->stop();
-}
\ No newline at end of file
+    leftTarget = q16_16();
+    rightTarget = q16_16();
+    output->stop();
+}
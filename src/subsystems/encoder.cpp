@@ -0,0 +1,96 @@
+// Standard headers
+#include <stdlib.h>
+#include <cstring>
+#include <initializer_list>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+
+#include "subsystems/encoder.h"
+
+static QuadratureEncoder *encoders[NUM_BANK0_GPIOS];
+
+// (previous AB << 2 | current AB) -> count delta, 0 for no change or an invalid double step
+static constexpr int8_t QUADRATURE_TABLE[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+
+static constexpr uint32_t EDGE_EVENTS = GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL;
+
+// Raw handler shared by all encoders, it only acknowledges encoder pins so other GPIO IRQ users keep working
+void QuadratureEncoder::irq_handler()
+{
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++)
+    {
+        if (encoders[gpio] == nullptr)
+            continue;
+
+        uint32_t events = gpio_get_irq_event_mask(gpio) & EDGE_EVENTS;
+        if (events == 0)
+            continue;
+
+        gpio_acknowledge_irq(gpio, events);
+        encoders[gpio]->handleEdge();
+    }
+}
+
+QuadratureEncoder::QuadratureEncoder(uint pinA, uint pinB, uint countsPerRevolution, Units<float> wheelDiameter, float readPeriod) : pinA(pinA),
+                                                                                                                                     pinB(pinB),
+                                                                                                                                     count(0),
+                                                                                                                                     windowIndex(0),
+                                                                                                                                     windowSum(0),
+                                                                                                                                     lastCount(0)
+{
+    std::memset(window, 0, sizeof(window));
+
+    float metersPerCount = wheelDiameter.meters() * 3.14159265f / (float)countsPerRevolution;
+    velocityPerCount = q16_16::fromFloat(metersPerCount / (readPeriod * ENCODER_WINDOW));
+
+    for (uint pin : {pinA, pinB})
+    {
+        gpio_init(pin);
+        gpio_set_dir(pin, false);
+        gpio_pull_up(pin);
+        encoders[pin] = this;
+    }
+
+    state = (gpio_get(pinA) << 1) | gpio_get(pinB);
+
+    // gpio_set_irq_callback would replace the callback of every other GPIO IRQ user on this core
+    gpio_add_raw_irq_handler_masked((1u << pinA) | (1u << pinB), irq_handler);
+    gpio_set_irq_enabled(pinA, EDGE_EVENTS, true);
+    gpio_set_irq_enabled(pinB, EDGE_EVENTS, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+QuadratureEncoder::~QuadratureEncoder()
+{
+    gpio_set_irq_enabled(pinA, EDGE_EVENTS, false);
+    gpio_set_irq_enabled(pinB, EDGE_EVENTS, false);
+    gpio_remove_raw_irq_handler_masked((1u << pinA) | (1u << pinB), irq_handler);
+    encoders[pinA] = nullptr;
+    encoders[pinB] = nullptr;
+    gpio_deinit(pinA);
+    gpio_deinit(pinB);
+}
+
+void QuadratureEncoder::handleEdge()
+{
+    uint8_t next = (gpio_get(pinA) << 1) | gpio_get(pinB);
+    count = count + QUADRATURE_TABLE[(state << 2) | next];
+    state = next;
+}
+
+bool QuadratureEncoder::read(q16_16 &velocity)
+{
+    int32_t current = count;
+    int32_t delta = current - lastCount;
+    lastCount = current;
+
+    windowSum += delta - window[windowIndex];
+    window[windowIndex] = delta;
+    windowIndex = (windowIndex + 1) % ENCODER_WINDOW;
+
+    velocity = velocityPerCount * windowSum;
+    return true;
+}
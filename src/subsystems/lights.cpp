@@ -5,10 +5,13 @@
 // Kernel headers
 #include <FreeRTOS.h>
 #include <task.h>
+#include <semphr.h>
 
 // Hardware headers
 #include <pico/stdlib.h>
-#include <hardware/pwm.h>
+#include <hardware/pio.h>
+#include <hardware/dma.h>
+#include <hardware/clocks.h>
 
 // Libraries
 #include <board/led.h>
@@ -17,129 +20,215 @@
 #include "config/options.h"
 
 #include "subsystems/lights.h"
-
-enum SPECIAL_GPIO
+#include "subsystems/animation.h"
+#include "lights.pio.h"
+
+// One table covers a full pulse cycle, DMA wraps its read address around it
+static constexpr uint TABLE_SIZE_BITS = 9;
+static constexpr uint TABLE_LENGTH = 1 << TABLE_SIZE_BITS;
+static constexpr uint TABLE_ENTRY_US = Config::Lights::PULSE_LENGTH / TABLE_LENGTH;
+static_assert(Config::Lights::PULSE_LENGTH % Config::Lights::BLINK_LENGTH == 0, "Blink cycles must fit the waveform table");
+
+// 14 bit PWM played RING_PWM_REPEAT times per table entry (fixed by ring_pwm), ~1 kHz
+static constexpr uint32_t RING_PWM_PERIOD = 0x3FFF;
+static constexpr uint RING_PWM_LEVEL_SHIFT = 2; // 16 bit gamma levels to the period
+static constexpr uint RING_PWM_REPEAT = 4;
+static constexpr uint32_t RING_PWM_CYCLES = RING_PWM_REPEAT * (3 * (RING_PWM_PERIOD + 1) + 3) + 2; // PIO cycles per table entry
+static_assert(1000000 * RING_PWM_REPEAT / TABLE_ENTRY_US >= 800, "Ring PWM must stay well above visible flicker");
+
+using Animation::Easing;
+using Animation::Keyframe;
+using Animation::Timeline;
+
+static constexpr Keyframe OFF_KEYFRAMES[] = {{0, 0, Easing::Step}};
+static constexpr Keyframe ON_KEYFRAMES[] = {{0, 0xFFFF, Easing::Step}};
+static constexpr Keyframe PULSE_KEYFRAMES[] = {{0, 0, Easing::Linear},
+                                               {Config::Lights::PULSE_HALF_LENGTH, Config::Lights::PULSE_HALF_LENGTH / Config::Lights::PULSE_DIVISOR, Easing::Linear}};
+static constexpr Keyframe BLINK_KEYFRAMES[] = {{0, 0xFFFF, Easing::Step},
+                                               {Config::Lights::BLINK_ON_LENGTH, 0, Easing::Step}};
+static constexpr Keyframe ALT2_KEYFRAMES[] = {{0, Config::Lights::PULSE_HALF_LENGTH / Config::Lights::PULSE_DIVISOR, Easing::Linear},
+                                              {Config::Lights::PULSE_HALF_LENGTH, 0, Easing::Linear}};
+
+static constexpr Timeline OFF_TIMELINE(OFF_KEYFRAMES, Config::Lights::PULSE_LENGTH);
+static constexpr Timeline ON_TIMELINE(ON_KEYFRAMES, Config::Lights::PULSE_LENGTH);
+static constexpr Timeline PULSE_TIMELINE(PULSE_KEYFRAMES, Config::Lights::PULSE_LENGTH);
+static constexpr Timeline BLINK_TIMELINE(BLINK_KEYFRAMES, Config::Lights::BLINK_LENGTH);
+static constexpr Timeline ALT2_TIMELINE(ALT2_KEYFRAMES, Config::Lights::PULSE_LENGTH);
+
+static constexpr std::array<uint16_t, 256> GAMMA = Animation::makeGammaTable<Config::Lights::GAMMA_EXPONENT>();
+
+// ring read wrapping needs the tables aligned to their size in bytes
+struct alignas(TABLE_LENGTH * sizeof(uint16_t)) WaveformTable
 {
-    STATUS_LED_GPIO = 255
+    uint16_t levels[TABLE_LENGTH];
 };
 
-void pwm_set_squared(uint gpio, uint16_t level)
+static constexpr WaveformTable make_table(const Timeline &timeline)
 {
-    uint16_t squared = ((level >> 8) + 1) * ((level >> 8) + 1) - 1;
-    if (gpio != STATUS_LED_GPIO)
-    {
-        pwm_set_gpio_level(gpio, squared);
-    }
-    else
-    {
-        BoardLed::set(level);
-    }
+    WaveformTable table{};
+    for (uint i = 0; i < TABLE_LENGTH; i++)
+        table.levels[i] = GAMMA[timeline.levelAt(i * TABLE_ENTRY_US) >> 8] >> RING_PWM_LEVEL_SHIFT;
+    return table;
 }
 
-void apply_pattern(uint gpio, Pattern pattern)
+// generated at compile time but kept in RAM so playback does not depend on XIP
+static constinit WaveformTable offTable = make_table(OFF_TIMELINE);
+static constinit WaveformTable onTable = make_table(ON_TIMELINE);
+static constinit WaveformTable pulseTable = make_table(PULSE_TIMELINE);
+static constinit WaveformTable blinkTable = make_table(BLINK_TIMELINE);
+static constinit WaveformTable alt2Table = make_table(ALT2_TIMELINE);
+
+struct PatternAnimation
 {
-    switch (pattern)
-    {
-    case Pattern::Off:
-    {
-        pwm_set_squared(gpio, 0);
-    }
-    break;
-    case Pattern::On:
-    {
-        pwm_set_squared(gpio, 0xFFFF);
-    }
-    break;
-    case Pattern::Pulse:
-    {
-        uint32_t cycleTime = time_us_32() % Config::Lights::PULSE_LENGTH;
-        if (cycleTime < Config::Lights::PULSE_HALF_LENGTH)
-            pwm_set_squared(gpio, cycleTime / Config::Lights::PULSE_DIVISOR);
-        else
-            pwm_set_squared(gpio, (Config::Lights::PULSE_LENGTH - cycleTime) / Config::Lights::PULSE_DIVISOR);
-    }
-    break;
-    case Pattern::Blink:
-    {
-        uint32_t cycleTime = time_us_32() % Config::Lights::BLINK_LENGTH;
-        if (cycleTime < Config::Lights::BLINK_ON_LENGTH)
-            pwm_set_squared(gpio, 0xFFFF);
-        else
-            pwm_set_squared(gpio, 0);
-    }
-    break;
-    case Pattern::Alt1:
-    {
-        uint32_t cycleTime = time_us_32() % Config::Lights::PULSE_LENGTH;
-        if (cycleTime < Config::Lights::PULSE_HALF_LENGTH)
-            pwm_set_squared(gpio, cycleTime / Config::Lights::PULSE_DIVISOR);
-        else
-            pwm_set_squared(gpio, (Config::Lights::PULSE_LENGTH - cycleTime) / Config::Lights::PULSE_DIVISOR);
-    }
-    break;
-    case Pattern::Alt2:
-    {
-        uint32_t cycleTime = time_us_32() % Config::Lights::PULSE_LENGTH;
-        if (cycleTime < Config::Lights::PULSE_HALF_LENGTH)
-            pwm_set_squared(gpio, 62500 - cycleTime / Config::Lights::PULSE_DIVISOR);
-        else
-            pwm_set_squared(gpio, 62500 - (Config::Lights::PULSE_LENGTH - cycleTime) / Config::Lights::PULSE_DIVISOR);
-    }
-    break;
-    }
+    const Timeline &timeline;
+    const WaveformTable &table;
+};
+
+// indexed by Pattern
+static constexpr PatternAnimation PATTERN_ANIMATIONS[] = {
+    {OFF_TIMELINE, offTable},
+    {ON_TIMELINE, onTable},
+    {PULSE_TIMELINE, pulseTable},
+    {BLINK_TIMELINE, blinkTable},
+    {PULSE_TIMELINE, pulseTable}, // Alt1
+    {ALT2_TIMELINE, alt2Table},
+};
+static_assert(sizeof(PATTERN_ANIMATIONS) / sizeof(PATTERN_ANIMATIONS[0]) == (size_t)Pattern::Alt2 + 1, "Every pattern needs an animation");
+
+static const PatternAnimation &pattern_animation(Pattern pattern)
+{
+    return PATTERN_ANIMATIONS[(size_t)pattern];
 }
 
 void animation_task(void *pv_lights)
 {
     Lights *lights = (Lights *)pv_lights;
 
+    // Only the status LED is animated here (it sits behind the wifi chip). The task
+    // sleeps until the next keyframe change or until the pattern changes.
     while (lights->isAnimationRunning())
     {
-        apply_pattern(lights->getLeftRingIndicatorPin(), lights->getLeftRingIndicatorPattern());
-        apply_pattern(lights->getRightRingIndicatorPin(), lights->getRightRingIndicatorPattern());
-        apply_pattern(STATUS_LED_GPIO, lights->getStatusLedPattern());
-        vTaskDelay(pdMS_TO_TICKS(2));
+        const Timeline &timeline = pattern_animation(lights->getStatusLedPattern()).timeline;
+        uint32_t now = time_us_32();
+        BoardLed::set(timeline.levelAt(now));
+
+        TickType_t wait;
+        if (timeline.isConstant())
+        {
+            wait = portMAX_DELAY;
+        }
+        else
+        {
+            uint32_t hold = timeline.holdTime(now);
+            wait = hold > 0 ? pdMS_TO_TICKS(hold / 1000 + 1) : pdMS_TO_TICKS(Config::Lights::ANIMATION_TICK_MS);
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
     }
 
     vTaskDelete(NULL);
 }
 
-Lights::Lights() : animationRunning(true), leftRingIndicatorPin(Config::Lights::RING_INDICATOR_LEFT_PIN), rightRingIndicatorPin(Config::Lights::RING_INDICATOR_RIGHT_PIN)
+Lights::Lights() : animationRunning(true),
+                   ringMutex(xSemaphoreCreateMutex()),
+                   leftRingIndicatorPin(Config::Lights::RING_INDICATOR_LEFT_PIN),
+                   rightRingIndicatorPin(Config::Lights::RING_INDICATOR_RIGHT_PIN),
+                   leftRingIndicatorPattern(Pattern::Off),
+                   rightRingIndicatorPattern(Pattern::Off),
+                   statusLedPattern(Pattern::Off)
 {
-    gpio_init(leftRingIndicatorPin);
-    gpio_init(rightRingIndicatorPin);
-
-    gpio_set_dir(leftRingIndicatorPin, true);
-    gpio_set_dir(rightRingIndicatorPin, true);
+    bool claimed = pio_claim_free_sm_and_add_program(&ring_pwm_program, &pio, &leftSm, &pioOffset);
+    hard_assert(claimed);
+    rightSm = pio_claim_unused_sm(pio, true);
 
-    gpio_set_function(leftRingIndicatorPin, GPIO_FUNC_PWM);
-    gpio_set_function(rightRingIndicatorPin, GPIO_FUNC_PWM);
+    float clkdiv = (float)clock_get_hz(clk_sys) * (TABLE_ENTRY_US / 1000000.0f) / RING_PWM_CYCLES;
+    ring_pwm_program_init(pio, leftSm, pioOffset, leftRingIndicatorPin, clkdiv);
+    ring_pwm_program_init(pio, rightSm, pioOffset, rightRingIndicatorPin, clkdiv);
 
-    uint slice_num_left = pwm_gpio_to_slice_num(leftRingIndicatorPin);
-    uint slice_num_right = pwm_gpio_to_slice_num(rightRingIndicatorPin);
+    leftDma = dma_claim_unused_channel(true);
+    rightDma = dma_claim_unused_channel(true);
 
-    pwm_config config = pwm_get_default_config();
-    pwm_config_set_clkdiv(&config, 4.f);
-    pwm_init(slice_num_left, &config, true);
-    pwm_init(slice_num_right, &config, true);
+    startRingIndicators();
 
     BoardLed::init();
 
-    xTaskCreate(animation_task, "LightAnimationThread", configMINIMAL_STACK_SIZE, this, (tskIDLE_PRIORITY + 2UL), &animationTask);
+    if (xTaskCreate(animation_task, "LightAnimationThread", configMINIMAL_STACK_SIZE, this, (tskIDLE_PRIORITY + 2UL), &animationTask) != pdPASS)
+        panic("Failed to create the LightAnimationThread task");
 }
 
 Lights::~Lights()
 {
     animationRunning = false;
+    xTaskNotifyGive(animationTask);
+
+    stopRingIndicators();
+    dma_channel_unclaim(leftDma);
+    dma_channel_unclaim(rightDma);
+    pio_sm_unclaim(pio, rightSm);
+    pio_remove_program_and_unclaim_sm(&ring_pwm_program, pio, leftSm, pioOffset);
+    vSemaphoreDelete(ringMutex);
+}
+
+void Lights::stopRingIndicators()
+{
+    pio_set_sm_mask_enabled(pio, (1u << leftSm) | (1u << rightSm), false);
+    dma_channel_abort(leftDma);
+    dma_channel_abort(rightDma);
+}
+
+void Lights::startRingIndicators()
+{
+    struct
+    {
+        uint sm;
+        uint dma;
+        const WaveformTable &table;
+    } rings[] = {{leftSm, leftDma, pattern_animation(leftRingIndicatorPattern).table},
+                 {rightSm, rightDma, pattern_animation(rightRingIndicatorPattern).table}};
+
+    for (const auto &ring : rings)
+    {
+        pio_sm_clear_fifos(pio, ring.sm);
+        pio_sm_restart(pio, ring.sm);
+        ring_pwm_set_period(pio, ring.sm, RING_PWM_PERIOD);
+        pio_sm_exec(pio, ring.sm, pio_encode_jmp(pioOffset));
+
+        dma_channel_config c = dma_channel_get_default_config(ring.dma);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_ring(&c, false, TABLE_SIZE_BITS + 1); // wrap the read address every table
+        channel_config_set_dreq(&c, pio_get_dreq(pio, ring.sm, true));
+
+        // one transfer per table entry, the maximum count lasts well over a hundred days
+        dma_channel_configure(ring.dma, &c, &pio->txf[ring.sm], ring.table.levels, 0xFFFFFFFF, false);
+    }
+
+    // start both rings on the same table entry so paired patterns stay in phase
+    dma_start_channel_mask((1u << leftDma) | (1u << rightDma));
+    pio_enable_sm_mask_in_sync(pio, (1u << leftSm) | (1u << rightSm));
 }
 
 void Lights::setRingIndicatorPattern(Pattern left, Pattern right)
 {
-    leftRingIndicatorPattern = left;
-    rightRingIndicatorPattern = right;
+    // main_task and NetworkBoot both set patterns, a restart must not interleave with another
+    xSemaphoreTake(ringMutex, portMAX_DELAY);
+    if (left != leftRingIndicatorPattern || right != rightRingIndicatorPattern)
+    {
+        leftRingIndicatorPattern = left;
+        rightRingIndicatorPattern = right;
+
+        stopRingIndicators();
+        startRingIndicators();
+    }
+    xSemaphoreGive(ringMutex);
 }
 
 void Lights::setStatusLedPattern(Pattern pattern)
 {
+    if (pattern == statusLedPattern)
+        return;
+
     statusLedPattern = pattern;
+    xTaskNotifyGive(animationTask);
 }
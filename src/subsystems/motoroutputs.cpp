@@ -0,0 +1,169 @@
+// Standard headers
+#include <stdlib.h>
+#include <cstring>
+#include <initializer_list>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "subsystems/motoroutputs.h"
+
+MotorOutputs::MotorOutputs(const ModuleConfig &left, const ModuleConfig &right) : outputs{{left.frontPinCW, left.frontPinCCW},
+                                                                                          {left.centerPinCW, left.centerPinCCW},
+                                                                                          {left.backPinCW, left.backPinCCW},
+                                                                                          {right.frontPinCW, right.frontPinCCW},
+                                                                                          {right.centerPinCW, right.centerPinCCW},
+                                                                                          {right.backPinCW, right.backPinCCW}},
+                                                                                  sliceMask(0),
+                                                                                  compensation(q16_16::fromInt(1)),
+                                                                                  dirty(true),
+                                                                                  commitCount(0)
+{
+    std::memset(levels, 0, sizeof(levels));
+    std::memset(channelMask, 0, sizeof(channelMask));
+
+    for (const Output &output : outputs)
+    {
+        for (uint pin : {output.pinCW, output.pinCCW})
+        {
+            gpio_set_function(pin, GPIO_FUNC_PWM);
+            uint slice = pwm_gpio_to_slice_num(pin);
+            channelMask[slice] |= 1 << pwm_gpio_to_channel(pin);
+            sliceMask |= 1 << slice;
+        }
+    }
+
+    referenceSlice = pwm_gpio_to_slice_num(outputs[0].pinCW);
+
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_wrap(&config, Config::Drivetrain::PWM_WRAP);
+    pwm_config_set_clkdiv(&config, Config::Drivetrain::PWM_CLKDIV);
+
+    for (uint slice = 0; slice < NUM_PWM_SLICES; slice++)
+    {
+        if (sliceMask & (1 << slice))
+        {
+            // keep channels not owned by a motor (shared slices) at their current level
+            uint32_t cc = pwm_hw->slice[slice].cc;
+            pwm_init(slice, &config, false);
+            pwm_hw->slice[slice].cc = cc & ~((channelMask[slice] & 1 ? PWM_CH0_CC_A_BITS : 0) | (channelMask[slice] & 2 ? PWM_CH0_CC_B_BITS : 0));
+            pwm_set_counter(slice, 0);
+        }
+    }
+
+    // start all slices with one enable write so their periods are phase aligned
+    hw_set_bits(&pwm_hw->en, sliceMask);
+}
+
+MotorOutputs::~MotorOutputs()
+{
+    stop();
+    hw_clear_bits(&pwm_hw->en, sliceMask);
+}
+
+void MotorOutputs::setPinLevel(uint pin, uint16_t level)
+{
+    uint16_t &staged = levels[pwm_gpio_to_slice_num(pin)][pwm_gpio_to_channel(pin)];
+    if (staged != level)
+    {
+        staged = level;
+        dirty = true;
+    }
+}
+
+void MotorOutputs::stage(MotorIndex motor, q16_16 duty)
+{
+    const Output &output = outputs[(uint)motor];
+    uint16_t level = (uint16_t)clamp((duty * compensation).abs(), q16_16(), q16_16::fromInt(1)).scaleTo(Config::Drivetrain::PWM_WRAP);
+
+    setPinLevel(output.pinCW, duty > q16_16() ? level : 0);
+    setPinLevel(output.pinCCW, duty < q16_16() ? level : 0);
+}
+
+void MotorOutputs::commit()
+{
+    if (!dirty)
+        return;
+
+    uint32_t cc[NUM_PWM_SLICES];
+    for (uint slice = 0; slice < NUM_PWM_SLICES; slice++)
+    {
+        cc[slice] = ((uint32_t)levels[slice][PWM_CHAN_B] << PWM_CH0_CC_B_LSB) | levels[slice][PWM_CHAN_A];
+    }
+
+    // Compare registers are double buffered and latch at wrap. Never start the burst right
+    // before a wrap, otherwise the slices would pick up the new levels one period apart.
+    // The wait runs with interrupts on, they are only off from the last check to the last write.
+    auto inGuard = [this]()
+    { return pwm_get_counter(referenceSlice) > Config::Drivetrain::PWM_WRAP - Config::Drivetrain::PWM_COMMIT_GUARD; };
+
+    uint32_t waitStart = time_us_32();
+    uint32_t irq;
+    while (true)
+    {
+        bool timedOut = time_us_32() - waitStart >= Config::Drivetrain::PWM_COMMIT_TIMEOUT_US;
+        if (!inGuard() || timedOut)
+        {
+            irq = save_and_disable_interrupts();
+            // an interrupt between the check and here can have run into the next window
+            if (!inGuard() || timedOut)
+                break;
+            restore_interrupts(irq);
+        }
+        tight_loop_contents();
+    }
+
+    for (uint slice = 0; slice < NUM_PWM_SLICES; slice++)
+    {
+        switch (channelMask[slice])
+        {
+        case 0:
+            break;
+        case 1:
+            pwm_hw->slice[slice].cc = (pwm_hw->slice[slice].cc & PWM_CH0_CC_B_BITS) | (cc[slice] & PWM_CH0_CC_A_BITS);
+            break;
+        case 2:
+            pwm_hw->slice[slice].cc = (pwm_hw->slice[slice].cc & PWM_CH0_CC_A_BITS) | (cc[slice] & PWM_CH0_CC_B_BITS);
+            break;
+        default:
+            pwm_hw->slice[slice].cc = cc[slice];
+            break;
+        }
+    }
+
+    restore_interrupts(irq);
+    dirty = false;
+    commitCount++;
+}
+
+void __not_in_flash_func(MotorOutputs::forceStop)()
+{
+    for (uint slice = 0; slice < NUM_PWM_SLICES; slice++)
+    {
+        if (channelMask[slice] != 0)
+            hw_clear_bits(&pwm_hw->slice[slice].cc, (channelMask[slice] & 1 ? PWM_CH0_CC_A_BITS : 0) | (channelMask[slice] & 2 ? PWM_CH0_CC_B_BITS : 0));
+    }
+
+    // the compare registers only latch at wrap, the pin mux switches immediately
+    for (const Output &output : outputs)
+    {
+        for (uint pin : {output.pinCW, output.pinCCW})
+        {
+            gpio_put(pin, false);
+            gpio_set_dir(pin, GPIO_OUT);
+            gpio_set_function(pin, GPIO_FUNC_SIO);
+        }
+    }
+}
+
+void MotorOutputs::stop()
+{
+    std::memset(levels, 0, sizeof(levels));
+    dirty = true;
+    commit();
+}
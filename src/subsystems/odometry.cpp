@@ -0,0 +1,141 @@
+// Standard headers
+#include <stdlib.h>
+
+// Hardware headers
+#include <pico/stdlib.h>
+#include <pico/critical_section.h>
+
+// Config headers
+#include "config/options.h"
+
+#include "math/fixedtrig.h"
+#include "subsystems/odometry.h"
+
+static constexpr int64_t PI_Q32 = 13493037705LL; // pi in Q32.32
+
+Odometry::Odometry(const FixedDifferentialDriveKinematics<16> &kinematics) : kinematics(kinematics),
+                                                                             current({}),
+                                                                             x(0),
+                                                                             y(0),
+                                                                             heading(0),
+                                                                             lastUpdateUs(0),
+                                                                             lastRecordUs(0),
+                                                                             forwardSpeed(),
+                                                                             angularSpeed(),
+                                                                             historyStart(0),
+                                                                             historyCount(0)
+{
+    critical_section_init(&lock);
+}
+
+void Odometry::update(q16_16 leftSpeed, q16_16 rightSpeed, uint64_t timeUs)
+{
+    FixedChassisSpeeds<16> speeds = kinematics.toChassisSpeeds({leftSpeed, rightSpeed});
+    forwardSpeed = speeds.vx;
+    angularSpeed = speeds.omega;
+
+    if (lastUpdateUs == 0)
+        lastUpdateUs = timeUs;
+
+    int64_t elapsedUs = (int64_t)(timeUs - lastUpdateUs);
+    lastUpdateUs = timeUs;
+
+    // Q16.16 speed * us -> Q32.32 distance
+    int64_t distance = ((int64_t)speeds.vx.raw() * elapsedUs << 16) / 1000000;
+    int64_t turn = ((int64_t)speeds.omega.raw() * elapsedUs << 16) / 1000000;
+
+    // midpoint heading integration
+    q16_16 midHeading = q16_16::fromRaw((int32_t)((heading + turn / 2) >> 16));
+    x += (distance * FixedTrig::cos(midHeading).raw()) >> 16;
+    y += (distance * FixedTrig::sin(midHeading).raw()) >> 16;
+    heading += turn;
+    if (heading >= PI_Q32)
+        heading -= 2 * PI_Q32;
+    else if (heading < -PI_Q32)
+        heading += 2 * PI_Q32;
+
+    Pose pose = {q16_16::fromRaw((int32_t)(x >> 16)), q16_16::fromRaw((int32_t)(y >> 16)), q16_16::fromRaw((int32_t)(heading >> 16))};
+
+    critical_section_enter_blocking(&lock);
+    current = {timeUs, pose};
+    if (timeUs - lastRecordUs >= Config::Drivetrain::ODOMETRY_HISTORY_PERIOD_US)
+    {
+        lastRecordUs = timeUs;
+        record(current);
+    }
+    critical_section_exit(&lock);
+}
+
+void Odometry::record(const TimestampedPose &sample)
+{
+    if (historyCount < HISTORY_SIZE)
+    {
+        history[(historyStart + historyCount) % HISTORY_SIZE] = sample;
+        historyCount++;
+    }
+    else
+    {
+        history[historyStart] = sample;
+        historyStart = (historyStart + 1) % HISTORY_SIZE;
+    }
+}
+
+const TimestampedPose &Odometry::historyAt(uint index)
+{
+    return history[(historyStart + index) % HISTORY_SIZE];
+}
+
+TimestampedPose Odometry::getPose()
+{
+    critical_section_enter_blocking(&lock);
+    TimestampedPose pose = current;
+    critical_section_exit(&lock);
+    return pose;
+}
+
+static q16_16 lerp(q16_16 a, q16_16 b, q16_16 t)
+{
+    return a + (b - a) * t;
+}
+
+bool Odometry::getPoseAt(uint64_t timeUs, Pose &out)
+{
+    critical_section_enter_blocking(&lock);
+
+    if (historyCount == 0 || timeUs < historyAt(0).timeUs)
+    {
+        critical_section_exit(&lock);
+        return false;
+    }
+
+    if (timeUs >= current.timeUs)
+    {
+        out = current.pose;
+        critical_section_exit(&lock);
+        return true;
+    }
+
+    // first sample after timeUs (the live pose if timeUs is past the last recorded one)
+    uint low = 0;
+    uint high = historyCount;
+    while (low < high)
+    {
+        uint mid = (low + high) / 2;
+        if (historyAt(mid).timeUs <= timeUs)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    TimestampedPose before = historyAt(low - 1);
+    TimestampedPose after = low < historyCount ? historyAt(low) : current;
+    critical_section_exit(&lock);
+
+    uint32_t spanUs = (uint32_t)(after.timeUs - before.timeUs);
+    q16_16 t = spanUs == 0 ? q16_16() : q16_16::fromRaw((int32_t)(((uint64_t)(timeUs - before.timeUs) << 16) / spanUs));
+
+    out.x = lerp(before.pose.x, after.pose.x, t);
+    out.y = lerp(before.pose.y, after.pose.y, t);
+    out.heading = FixedTrig::wrap(before.pose.heading + FixedTrig::wrap(after.pose.heading - before.pose.heading) * t);
+    return true;
+}
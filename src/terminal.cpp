@@ -1,67 +1,375 @@
 // Standard headers
 #include <stdlib.h>
-#include <string>
-#include <cstdarg>
+#include <stdio.h>
 #include <cstring>
 
 // Kernel headers
 #include <FreeRTOS.h>
 #include <task.h>
 
-#include "terminal.h"
+// Hardware headers
+#include <pico/stdlib.h>
+
+// Libraries
 #include <lwipdebug.h>
+#include <lwip/stats.h>
+#include <lwip/memp.h>
+#include <lwip/tcpip.h>
 
-TaskHandle_t task;
-bool isRunning = false;
+#include "math/fixed.h"
+#include "diagnostics.h"
+#include "terminal.h"
 
-void Terminal::start()
+static constexpr int MAX_TASKS = 24;
+static constexpr uint32_t INPUT_POLL_MS = 10;
+static constexpr unsigned LWIP_SIZING_HEADROOM_PERCENT = 25;
+
+static TaskHandle_t task;
+static volatile bool isRunning = false;
+
+// fixed tables, nothing is allocated after boot
+static Terminal::Command commands[Terminal::MAX_COMMANDS];
+static volatile int commandCount = 0;
+static Terminal::Tunable tunables[Terminal::MAX_TUNABLES];
+static volatile int tunableCount = 0;
+
+static char line[Terminal::LINE_LENGTH];
+static int lineLength = 0;
+
+bool Terminal::registerCommand(const Command &command)
 {
-    isRunning = true;
-    printf("[Termnal] Creating task\n");
-    xTaskCreate(terminal_task, "Terminal", configMAIN_THREAD_STACK_SIZE, NULL, (tskIDLE_PRIORITY + 4UL), &task);
+    if (commandCount >= MAX_COMMANDS)
+        return false;
+
+    commands[commandCount] = command;
+    commandCount = commandCount + 1;
+    return true;
 }
 
-void Terminal::stop()
+bool Terminal::registerTunable(const Tunable &tunable)
 {
-    isRunning = false;
+    if (tunableCount >= MAX_TUNABLES)
+        return false;
+
+    tunables[tunableCount] = tunable;
+    tunableCount = tunableCount + 1;
+    return true;
 }
 
-void terminal_task(__unused void *params)
+static const Terminal::Tunable *find_tunable(const char *name)
 {
-    static char buffer[256];
+    for (int i = 0; i < tunableCount; i++)
+        if (strcmp(tunables[i].name, name) == 0)
+            return &tunables[i];
+    return nullptr;
+}
+
+static void print_tunable(const Terminal::Tunable &tunable)
+{
+    float value = tunable.type == Terminal::TunableType::Float ? *(float *)tunable.value : ((q16_16 *)tunable.value)->toFloat();
+    printf("%s = %f\n", tunable.name, value);
+}
+
+static void help_command(int argc, char **argv, void *context)
+{
+    for (int i = 0; i < commandCount; i++)
+        printf("%-10s %-18s %s\n", commands[i].name, commands[i].usage, commands[i].help);
+}
+
+static char task_state(eTaskState state)
+{
+    switch (state)
+    {
+    case eRunning:
+        return 'X';
+    case eReady:
+        return 'R';
+    case eBlocked:
+        return 'B';
+    case eSuspended:
+        return 'S';
+    case eDeleted:
+        return 'D';
+    default:
+        return '?';
+    }
+}
+
+static void tasks_command(int argc, char **argv, void *context)
+{
+    static TaskStatus_t statuses[MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE totalRuntime;
+    UBaseType_t count = uxTaskGetSystemState(statuses, MAX_TASKS, &totalRuntime);
+    if (count == 0)
+    {
+        printf("More than %d tasks\n", MAX_TASKS);
+        return;
+    }
+
+    // percent of one core, so the total is up to 100 * configNUMBER_OF_CORES
+    totalRuntime /= 100;
+
+    printf("%-22s S Pri Core Stack   CPU%%\n", "Name");
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t &status = statuses[i];
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+        unsigned long affinity = (unsigned long)status.uxCoreAffinityMask;
+#else
+        unsigned long affinity = 1;
+#endif
+        printf("%-22s %c %3u %4lx %5lu %5lu\n", status.pcTaskName, task_state(status.eCurrentState), (unsigned)status.uxCurrentPriority,
+               affinity, (unsigned long)status.usStackHighWaterMark,
+               totalRuntime > 0 ? (unsigned long)(status.ulRunTimeCounter / totalRuntime) : 0UL);
+    }
+}
+
+static void heap_command(int argc, char **argv, void *context)
+{
+    HeapStats_t stats;
+    vPortGetHeapStats(&stats);
+    printf("Heap: %u of %u bytes free, minimum ever %u\n", (unsigned)stats.xAvailableHeapSpaceInBytes, (unsigned)configTOTAL_HEAP_SIZE, (unsigned)stats.xMinimumEverFreeBytesRemaining);
+    printf("Blocks: %u free, largest %u, smallest %u\n", (unsigned)stats.xNumberOfFreeBlocks, (unsigned)stats.xSizeOfLargestFreeBlockInBytes, (unsigned)stats.xSizeOfSmallestFreeBlockInBytes);
+    printf("Allocations: %u, frees: %u\n", (unsigned)stats.xNumberOfSuccessfulAllocations, (unsigned)stats.xNumberOfSuccessfulFrees);
+}
+
+#if LWIP_STATS && MEMP_STATS && MEM_STATS
+static uint32_t captureStartUs = 0;
+
+/// @brief Resets the pool peaks to the current usage, so the next report covers only this session
+static void lwip_capture_start()
+{
+    // peaks are updated by lwIP under its own protection, an allocation racing the reset can be missed
+    LOCK_TCPIP_CORE();
+    for (int i = 0; i < MEMP_MAX; i++)
+        memp_pools[i]->stats->max = memp_pools[i]->stats->used;
+    lwip_stats.mem.max = lwip_stats.mem.used;
+    UNLOCK_TCPIP_CORE();
+
+    captureStartUs = time_us_32();
+    printf("Capturing lwIP peaks, drive then run \"lwip sizing\"\n");
+}
+
+static unsigned with_headroom(unsigned peak)
+{
+    unsigned headroom = peak * LWIP_SIZING_HEADROOM_PERCENT / 100;
+    return peak + (headroom > 0 ? headroom : 1);
+}
+
+/// @brief Prints lwipopts.h sizes from the captured peaks
+static void lwip_sizing()
+{
+    printf("// %lu s capture, peak + %u%%\n", (unsigned long)((time_us_32() - captureStartUs) / 1000000), LWIP_SIZING_HEADROOM_PERCENT);
+    printf("#define MEM_SIZE %u\n", with_headroom(lwip_stats.mem.max));
+    printf("#define MEMP_NUM_TCP_SEG %u\n", with_headroom(memp_pools[MEMP_TCP_SEG]->stats->max));
+    printf("#define MEMP_NUM_TCP_PCB %u\n", with_headroom(memp_pools[MEMP_TCP_PCB]->stats->max));
+    printf("#define MEMP_NUM_UDP_PCB %u\n", with_headroom(memp_pools[MEMP_UDP_PCB]->stats->max));
+    printf("#define PBUF_POOL_SIZE %u\n", with_headroom(memp_pools[MEMP_PBUF_POOL]->stats->max));
+}
+#endif
+
+static void lwip_command(int argc, char **argv, void *context)
+{
+    if (argc > 1 && strcmp(argv[1], "pcbs") == 0)
+    {
+        LWIP::PrintLwipTcpPcbStatus();
+        return;
+    }
+
+#if LWIP_STATS && MEMP_STATS && MEM_STATS
+    if (argc > 1 && strcmp(argv[1], "capture") == 0)
+    {
+        lwip_capture_start();
+        return;
+    }
+    if (argc > 1 && strcmp(argv[1], "sizing") == 0)
+    {
+        lwip_sizing();
+        return;
+    }
+
+    printf("%-18s  used   max avail   err\n", "Pool");
+    for (int i = 0; i < MEMP_MAX; i++)
+    {
+        const stats_mem *stats = memp_pools[i]->stats;
+        printf("%-18s %5u %5u %5u %5u\n", memp_pools[i]->desc, (unsigned)stats->used, (unsigned)stats->max, (unsigned)stats->avail, (unsigned)stats->err);
+    }
+    printf("%-18s %5u %5u %5u %5u\n", "HEAP", (unsigned)lwip_stats.mem.used, (unsigned)lwip_stats.mem.max, (unsigned)lwip_stats.mem.avail, (unsigned)lwip_stats.mem.err);
+#else
+    printf("lwIP statistics are disabled in this build (ROVER_PROFILE release)\n");
+#endif
+}
+
+static void tunables_command(int argc, char **argv, void *context)
+{
+    for (int i = 0; i < tunableCount; i++)
+        print_tunable(tunables[i]);
+}
+
+static void get_command(int argc, char **argv, void *context)
+{
+    if (argc != 2)
+    {
+        printf("Usage: get <name>\n");
+        return;
+    }
+
+    const Terminal::Tunable *tunable = find_tunable(argv[1]);
+    if (tunable == nullptr)
+    {
+        printf("Unknown tunable: %s\n", argv[1]);
+        return;
+    }
+
+    print_tunable(*tunable);
+}
+
+static void set_command(int argc, char **argv, void *context)
+{
+    if (argc != 3)
+    {
+        printf("Usage: set <name> <value>\n");
+        return;
+    }
+
+    const Terminal::Tunable *tunable = find_tunable(argv[1]);
+    if (tunable == nullptr)
+    {
+        printf("Unknown tunable: %s\n", argv[1]);
+        return;
+    }
+
+    char *end;
+    float value = strtof(argv[2], &end);
+    if (end == argv[2] || *end != 0)
+    {
+        printf("Invalid value: %s\n", argv[2]);
+        return;
+    }
+
+    // single aligned 32-bit store, safe against readers on either core
+    if (tunable->type == Terminal::TunableType::Float)
+        *(float *)tunable->value = value;
+    else
+        *(q16_16 *)tunable->value = q16_16::fromFloat(value);
+
+    print_tunable(*tunable);
+}
+
+static void diag_command(int argc, char **argv, void *context)
+{
+    if (argc == 2 && strcmp(argv[1], "kinematics") == 0)
+        Diagnostics::kinematicsReport();
+    else if (argc == 2 && strcmp(argv[1], "velocity") == 0)
+        Diagnostics::velocityControllerReport();
+    else if (argc == 2 && strcmp(argv[1], "udp") == 0)
+        Diagnostics::udpLatencyReport();
+    else if (argc == 2 && strcmp(argv[1], "bench") == 0)
+        Diagnostics::benchmarkReport();
+    else
+        printf("Usage: diag kinematics|velocity|udp|bench\n");
+}
+
+static void dispatch(char *input)
+{
+    char *argv[Terminal::MAX_ARGS];
+    int argc = 0;
+
+    // split in place on whitespace
+    char *cursor = input;
+    while (*cursor != 0)
+    {
+        while (*cursor == ' ' || *cursor == '\t')
+            *cursor++ = 0;
+        if (*cursor == 0)
+            break;
+
+        if (argc == Terminal::MAX_ARGS)
+        {
+            printf("Too many arguments\n");
+            return;
+        }
+        argv[argc++] = cursor;
+
+        while (*cursor != 0 && *cursor != ' ' && *cursor != '\t')
+            cursor++;
+    }
+
+    if (argc == 0)
+        return;
+
+    for (int i = 0; i < commandCount; i++)
+    {
+        if (strcmp(commands[i].name, argv[0]) == 0)
+        {
+            commands[i].handler(argc, argv, commands[i].context);
+            return;
+        }
+    }
+
+    printf("Unknown command: %s (try help)\n", argv[0]);
+}
+
+static void terminal_task(__unused void *params)
+{
+    fputs("> ", stdout);
 
     while (isRunning)
     {
-        puts("> ");
+        int c = getchar_timeout_us(0);
+        if (c == PICO_ERROR_TIMEOUT)
+        {
+            vTaskDelay(pdMS_TO_TICKS(INPUT_POLL_MS));
+            continue;
+        }
 
-        // read line from stdin
-        if (fgets(buffer, sizeof(buffer), stdin) != NULL)
+        if (c == '\r' || c == '\n')
+        {
+            putchar('\n');
+            line[lineLength] = 0;
+            dispatch(line);
+            lineLength = 0;
+            fputs("> ", stdout);
+        }
+        else if ((c == '\b' || c == 0x7F) && lineLength > 0)
+        {
+            lineLength--;
+            fputs("\b \b", stdout);
+        }
+        else if (c >= ' ' && c < 0x7F && lineLength < Terminal::LINE_LENGTH - 1)
         {
-            // remove newline character
-            buffer[strcspn(buffer, "\n")] = 0;
-            std::string command(buffer);
-
-            printf("[Terminal] Received command: %*.s\n", command.length(), command.c_str());
-
-            // process command
-            if (command == "help")
-            {
-                printf("Available commands:\n");
-                printf("help - Show this help message\n");
-                printf("lwip status - Print status of LWIP stack\n");
-            }
-            else if (command == "lwip status")
-            {
-                LWIP::PrintLwipTcpPcbStatus();
-            }
-            else
-            {
-                printf("Unknown command: %s\n", command.c_str());
-            }
-
-            vTaskDelay(pdMS_TO_TICKS(100));
+            line[lineLength++] = (char)c;
+            putchar(c);
         }
+    }
+
+    printf("[Terminal] Stopping task\n");
+    vTaskDelete(NULL);
+}
+
+void Terminal::start()
+{
+    static bool builtinsRegistered = false;
+    if (!builtinsRegistered)
+    {
+        builtinsRegistered = true;
+        registerCommand({"help", "", "Show this help message", help_command, nullptr});
+        registerCommand({"tasks", "", "Task states, priorities, core affinity, stack headroom (words) and CPU use", tasks_command, nullptr});
+        registerCommand({"heap", "", "FreeRTOS heap usage and fragmentation", heap_command, nullptr});
+        registerCommand({"lwip", "[pcbs|capture|sizing]", "lwIP pool usage and peak capture, or TCP PCB status", lwip_command, nullptr});
+        registerCommand({"tunables", "", "List live tunables", tunables_command, nullptr});
+        registerCommand({"get", "<name>", "Print a tunable", get_command, nullptr});
+        registerCommand({"set", "<name> <value>", "Change a tunable", set_command, nullptr});
+        registerCommand({"diag", "kinematics|velocity|udp|bench", "Run a diagnostics report", diag_command, nullptr});
+    }
 
-        printf("[Terminal] Stopping task\n");
-        vTaskDelete(NULL);
-    }
\ No newline at end of file
+    isRunning = true;
+    printf("[Terminal] Creating task\n");
+    if (xTaskCreate(terminal_task, "Terminal", configMAIN_THREAD_STACK_SIZE, NULL, (tskIDLE_PRIORITY + 4UL), &task) != pdPASS)
+        panic("Failed to create the Terminal task");
+}
+
+void Terminal::stop()
+{
+    isRunning = false;
+}
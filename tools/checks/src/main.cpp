@@ -0,0 +1,39 @@
+// Standard headers
+#include <stdio.h>
+#include <string.h>
+
+#include "checks.h"
+
+static bool kinematics()
+{
+    Checks::KinematicsResult result = Checks::kinematics();
+    printf("[KIN] %s: max error %li LSB (limit %li) over %i samples\n", result.pass ? "PASS" : "FAIL",
+           (long)result.maxErrorLsb, (long)Checks::KINEMATICS_MAX_ERROR_LSB, result.samples);
+    return result.pass;
+}
+
+static bool velocity()
+{
+    Checks::StepResponse response = Checks::velocityStep(true);
+    printf("[VEL] %s: final %.3f m/s (error %.3f, limit %.3f), rise %.3f s (limit %.3f), overshoot %.1f%% (limit %.1f%%)\n",
+           response.pass ? "PASS" : "FAIL", response.finalVelocity, response.error, Checks::VELOCITY_MAX_ERROR,
+           response.riseTime, Checks::VELOCITY_MAX_RISE_TIME, response.overshoot * 100.0f, Checks::VELOCITY_MAX_OVERSHOOT * 100.0f);
+    return response.pass;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        printf("usage: rover_checks kinematics|velocity\n");
+        return 2;
+    }
+
+    if (strcmp(argv[1], "kinematics") == 0)
+        return kinematics() ? 0 : 1;
+    if (strcmp(argv[1], "velocity") == 0)
+        return velocity() ? 0 : 1;
+
+    printf("Unknown check %s\n", argv[1]);
+    return 2;
+}
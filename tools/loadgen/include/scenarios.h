@@ -0,0 +1,44 @@
+#ifndef _LOADGEN_SCENARIOS_H
+#define _LOADGEN_SCENARIOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+struct LoadOptions
+{
+    std::string host = "127.0.0.1";
+    int driverstationPort = 5002; // Config::Control::DRIVERSTATION_PORT
+    int xboxPort = 5001;          // Config::Control::XBOX_UDP_PORT
+    int ntPort = 5810;            // NT4 server
+    int clients = 1;
+    double rate = 50.0;     // messages per second per client
+    double duration = 10.0; // s
+    int malformedPercent = 0;
+    size_t xboxSize = 16; // bytes of an all zero (neutral) Xbox report
+};
+
+struct LoadReport
+{
+    std::string name;
+    int clients;
+    int connected; // clients that completed the handshake (UDP: sockets opened)
+    uint64_t sent;
+    uint64_t malformed; // part of sent
+    uint64_t received;  // every text or binary message, broadcasts included
+    uint64_t errors;    // failed connects, sends and dropped connections
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    double seconds;
+    std::vector<uint32_t> latenciesUs; // request to matching response
+};
+
+/// @brief ClockSync round trips on the driverstation WebSocket (driverstation.pico.rover)
+LoadReport runDriverstation(const LoadOptions &options);
+/// @brief NT4 timestamp round trips on the NetworkTables WebSocket
+LoadReport runNetworkTables(const LoadOptions &options);
+/// @brief Xbox datagrams, fire and forget (throughput and send errors only)
+LoadReport runXbox(const LoadOptions &options);
+
+#endif
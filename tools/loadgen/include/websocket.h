@@ -0,0 +1,66 @@
+#ifndef _LOADGEN_WEBSOCKET_H
+#define _LOADGEN_WEBSOCKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+enum class WsOpcode : uint8_t
+{
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA
+};
+
+struct WsMessage
+{
+    WsOpcode opcode;
+    std::vector<uint8_t> payload;
+};
+
+/// @brief Blocking RFC 6455 client, just enough for load generation: unfragmented frames,
+/// masked sends, pings answered inside receive.
+class WsClient
+{
+public:
+    WsClient();
+    ~WsClient();
+
+    /// @brief Connects and upgrades, protocol goes in Sec-WebSocket-Protocol
+    bool connect(const std::string &host, int port, const std::string &path, const std::string &protocol, int timeoutMs);
+    void close();
+
+    bool isOpen()
+    {
+        return fd >= 0;
+    }
+
+    bool send(WsOpcode opcode, const uint8_t *data, size_t length);
+
+    /// @brief Waits up to timeoutMs for a text or binary message
+    /// @return False on timeout or a closed connection (see isOpen)
+    bool receive(WsMessage &out, int timeoutMs);
+
+    uint64_t getBytesSent()
+    {
+        return bytesSent;
+    }
+    uint64_t getBytesReceived()
+    {
+        return bytesReceived;
+    }
+
+private:
+    bool readExact(uint8_t *data, size_t length, int timeoutMs);
+    bool writeAll(const uint8_t *data, size_t length);
+
+    int fd;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+};
+
+#endif
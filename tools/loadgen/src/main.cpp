@@ -0,0 +1,134 @@
+// Standard headers
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "scenarios.h"
+
+static void usage()
+{
+    printf("Usage: loadgen [options] [host]\n"
+           "  Drives the rover's endpoints (default host 127.0.0.1, e.g. a local stand-in)\n"
+           "  --mode ds|nt|xbox|all   endpoints to load, all runs them at the same time (default ds)\n"
+           "  --clients N             connections or sockets per endpoint (default 1)\n"
+           "  --rate HZ               messages per second per client (default 50)\n"
+           "  --duration S            run length in seconds (default 10)\n"
+           "  --malformed PERCENT     share of messages replaced by malformed ones (default 0)\n"
+           "  --ds-port P             driverstation WebSocket port (default 5002)\n"
+           "  --nt-port P             NetworkTables WebSocket port (default 5810)\n"
+           "  --xbox-port P           Xbox UDP port (default 5001)\n"
+           "  --xbox-size N           bytes of the neutral (all zero) Xbox report (default 16)\n"
+           "  --json                  one JSON object per endpoint instead of the table\n");
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void print_report(LoadReport &report, bool json)
+{
+    std::sort(report.latenciesUs.begin(), report.latenciesUs.end());
+    double seconds = report.seconds > 0 ? report.seconds : 1;
+    uint32_t p50 = percentile(report.latenciesUs, 50);
+    uint32_t p90 = percentile(report.latenciesUs, 90);
+    uint32_t p99 = percentile(report.latenciesUs, 99);
+    uint32_t max = report.latenciesUs.empty() ? 0 : report.latenciesUs.back();
+
+    if (json)
+    {
+        printf("{\"endpoint\":\"%s\",\"clients\":%d,\"connected\":%d,\"seconds\":%.2f,\"sent\":%llu,\"malformed\":%llu,\"received\":%llu,"
+               "\"errors\":%llu,\"sent_per_s\":%.1f,\"received_per_s\":%.1f,\"bytes_sent_per_s\":%.0f,\"bytes_received_per_s\":%.0f,"
+               "\"latency_samples\":%zu,\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"max_us\":%u}\n",
+               report.name.c_str(), report.clients, report.connected, report.seconds, (unsigned long long)report.sent, (unsigned long long)report.malformed,
+               (unsigned long long)report.received, (unsigned long long)report.errors, report.sent / seconds, report.received / seconds,
+               report.bytesSent / seconds, report.bytesReceived / seconds, report.latenciesUs.size(), p50, p90, p99, max);
+        return;
+    }
+
+    printf("%s: %d/%d clients connected, %.1f s\n", report.name.c_str(), report.connected, report.clients, report.seconds);
+    printf("  sent     %8llu (%llu malformed)  %8.1f msg/s  %8.0f B/s\n", (unsigned long long)report.sent, (unsigned long long)report.malformed,
+           report.sent / seconds, report.bytesSent / seconds);
+    printf("  received %8llu                  %8.1f msg/s  %8.0f B/s\n", (unsigned long long)report.received, report.received / seconds, report.bytesReceived / seconds);
+    printf("  errors   %8llu\n", (unsigned long long)report.errors);
+    if (report.latenciesUs.empty())
+        printf("  latency  no round trips\n");
+    else
+        printf("  latency  p50 %u us  p90 %u us  p99 %u us  max %u us (%zu samples)\n", p50, p90, p99, max, report.latenciesUs.size());
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    std::string mode = "ds";
+    bool json = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--json")
+            json = true;
+        else if (arg == "--mode" && hasValue)
+            mode = argv[++i];
+        else if (arg == "--clients" && hasValue)
+            options.clients = atoi(argv[++i]);
+        else if (arg == "--rate" && hasValue)
+            options.rate = atof(argv[++i]);
+        else if (arg == "--duration" && hasValue)
+            options.duration = atof(argv[++i]);
+        else if (arg == "--malformed" && hasValue)
+            options.malformedPercent = atoi(argv[++i]);
+        else if (arg == "--ds-port" && hasValue)
+            options.driverstationPort = atoi(argv[++i]);
+        else if (arg == "--nt-port" && hasValue)
+            options.ntPort = atoi(argv[++i]);
+        else if (arg == "--xbox-port" && hasValue)
+            options.xboxPort = atoi(argv[++i]);
+        else if (arg == "--xbox-size" && hasValue)
+            options.xboxSize = (size_t)atoi(argv[++i]);
+        else if (arg[0] != '-')
+            options.host = arg;
+        else
+        {
+            usage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    bool runDs = mode == "ds" || mode == "all";
+    bool runNt = mode == "nt" || mode == "all";
+    bool runXb = mode == "xbox" || mode == "all";
+    if ((!runDs && !runNt && !runXb) || options.clients < 1 || options.rate <= 0 || options.duration <= 0 ||
+        options.malformedPercent < 0 || options.malformedPercent > 100)
+    {
+        usage();
+        return 1;
+    }
+
+    // endpoints run at the same time, the rover sees the combined load
+    std::vector<std::future<LoadReport>> runs;
+    if (runDs)
+        runs.push_back(std::async(std::launch::async, runDriverstation, std::cref(options)));
+    if (runNt)
+        runs.push_back(std::async(std::launch::async, runNetworkTables, std::cref(options)));
+    if (runXb)
+        runs.push_back(std::async(std::launch::async, runXbox, std::cref(options)));
+
+    bool failed = false;
+    for (std::future<LoadReport> &run : runs)
+    {
+        LoadReport report = run.get();
+        print_report(report, json);
+        failed |= report.connected == 0;
+    }
+    return failed ? 2 : 0;
+}
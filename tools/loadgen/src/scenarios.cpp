@@ -0,0 +1,313 @@
+// Standard headers
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+
+// System headers
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "scenarios.h"
+#include "websocket.h"
+
+static constexpr int CONNECT_TIMEOUT_MS = 2000;
+static constexpr uint8_t CLOCK_SYNC_PACKET = 0x00; // PacketType::ClockSync
+static constexpr size_t MAX_MALFORMED_LENGTH = 64;
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void put_uint64(std::vector<uint8_t> &out, uint64_t value)
+{
+    out.push_back(0xcf);
+    for (int shift = 56; shift >= 0; shift -= 8)
+        out.push_back((uint8_t)(value >> shift));
+}
+
+/// @brief Reads a msgpack integer of any width, advancing offset
+static bool read_uint(const std::vector<uint8_t> &in, size_t &offset, uint64_t &out)
+{
+    if (offset >= in.size())
+        return false;
+
+    uint8_t tag = in[offset++];
+    if (tag <= 0x7f)
+    {
+        out = tag;
+        return true;
+    }
+    if (tag >= 0xe0)
+    {
+        out = (uint64_t)(int64_t)(int8_t)tag; // negative fixint
+        return true;
+    }
+
+    size_t width;
+    switch (tag)
+    {
+    case 0xcc:
+    case 0xd0:
+        width = 1;
+        break;
+    case 0xcd:
+    case 0xd1:
+        width = 2;
+        break;
+    case 0xce:
+    case 0xd2:
+        width = 4;
+        break;
+    case 0xcf:
+    case 0xd3:
+        width = 8;
+        break;
+    default:
+        return false;
+    }
+
+    if (offset + width > in.size())
+        return false;
+    out = 0;
+    for (size_t i = 0; i < width; i++)
+        out = (out << 8) | in[offset++];
+    return true;
+}
+
+static std::vector<uint8_t> random_bytes(std::mt19937 &generator, size_t length)
+{
+    std::vector<uint8_t> out(length);
+    for (uint8_t &b : out)
+        b = (uint8_t)generator();
+    return out;
+}
+
+typedef std::function<std::vector<uint8_t>(uint64_t clientTimeUs, bool malformed, std::mt19937 &generator)> RequestBuilder;
+/// @brief Returns true and the echoed client time if the message answers one of our requests
+typedef std::function<bool(const std::vector<uint8_t> &message, uint64_t &clientTimeUs)> ResponseParser;
+
+static void merge(LoadReport &into, const LoadReport &from)
+{
+    into.connected += from.connected;
+    into.sent += from.sent;
+    into.malformed += from.malformed;
+    into.received += from.received;
+    into.errors += from.errors;
+    into.bytesSent += from.bytesSent;
+    into.bytesReceived += from.bytesReceived;
+    into.latenciesUs.insert(into.latenciesUs.end(), from.latenciesUs.begin(), from.latenciesUs.end());
+}
+
+static void websocket_client(const LoadOptions &options, int index, int port, const std::string &path, const std::string &protocol,
+                             const RequestBuilder &build, const ResponseParser &parse, LoadReport &result)
+{
+    std::mt19937 generator(std::random_device{}() + index);
+    WsClient client;
+    if (!client.connect(options.host, port, path, protocol, CONNECT_TIMEOUT_MS))
+    {
+        result.errors++;
+        return;
+    }
+    result.connected = 1;
+
+    uint64_t periodUs = (uint64_t)(1000000.0 / options.rate);
+    uint64_t endUs = now_us() + (uint64_t)(options.duration * 1000000.0);
+    // spread the clients over one period so they do not send in lockstep
+    uint64_t nextUs = now_us() + periodUs * index / options.clients;
+
+    while (now_us() < endUs && client.isOpen())
+    {
+        // receive until the next send is due
+        WsMessage message;
+        int64_t waitUs = (int64_t)(nextUs - now_us());
+        while (waitUs > 0 && client.receive(message, (int)((waitUs + 999) / 1000)))
+        {
+            result.received++;
+            uint64_t clientTimeUs;
+            if (message.opcode == WsOpcode::Binary && parse(message.payload, clientTimeUs))
+                result.latenciesUs.push_back((uint32_t)(now_us() - clientTimeUs));
+            waitUs = (int64_t)(nextUs - now_us());
+        }
+        if (!client.isOpen())
+            break;
+
+        bool malformed = (int)(generator() % 100) < options.malformedPercent;
+        std::vector<uint8_t> request = build(now_us(), malformed, generator);
+        if (!client.send(WsOpcode::Binary, request.data(), request.size()))
+            break;
+        result.sent++;
+        if (malformed)
+            result.malformed++;
+        nextUs += periodUs;
+    }
+
+    if (!client.isOpen())
+        result.errors++; // dropped by the rover (or a send failed) before the run ended
+    result.bytesSent = client.getBytesSent();
+    result.bytesReceived = client.getBytesReceived();
+}
+
+static LoadReport run_websocket(const LoadOptions &options, const char *name, int port, const std::string &pathPrefix, const std::string &protocol,
+                                const RequestBuilder &build, const ResponseParser &parse)
+{
+    std::vector<LoadReport> results(options.clients, LoadReport{});
+    std::vector<std::thread> threads;
+
+    uint64_t startUs = now_us();
+    for (int i = 0; i < options.clients; i++)
+    {
+        std::string path = pathPrefix.empty() ? "/" : pathPrefix + std::to_string(i);
+        threads.emplace_back(websocket_client, std::cref(options), i, port, path, protocol, std::cref(build), std::cref(parse), std::ref(results[i]));
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    LoadReport report = {};
+    report.name = name;
+    report.clients = options.clients;
+    report.seconds = (now_us() - startUs) / 1e6;
+    for (const LoadReport &result : results)
+        merge(report, result);
+    return report;
+}
+
+LoadReport runDriverstation(const LoadOptions &options)
+{
+    // [PacketType::ClockSync][ClockSyncRequestPacket{clientTime}]
+    RequestBuilder build = [](uint64_t clientTimeUs, bool malformed, std::mt19937 &generator)
+    {
+        std::vector<uint8_t> request = {CLOCK_SYNC_PACKET};
+        if (!malformed)
+        {
+            put_uint64(request, clientTimeUs);
+            return request;
+        }
+
+        switch (generator() % 3)
+        {
+        case 0: // packet type without a body
+            break;
+        case 1: // wrong msgpack type for clientTime
+            request.push_back(0xc0);
+            break;
+        default: // unknown packet type and noise
+            request = random_bytes(generator, 1 + generator() % MAX_MALFORMED_LENGTH);
+            request[0] = 0xEE;
+            break;
+        }
+        return request;
+    };
+
+    // [PacketType::ClockSync][ClockSyncPacket{clientTime, serverTime}]
+    ResponseParser parse = [](const std::vector<uint8_t> &message, uint64_t &clientTimeUs)
+    {
+        size_t offset = 1;
+        return message.size() > 1 && message[0] == CLOCK_SYNC_PACKET && read_uint(message, offset, clientTimeUs);
+    };
+
+    return run_websocket(options, "driverstation", options.driverstationPort, "", "driverstation.pico.rover", build, parse);
+}
+
+LoadReport runNetworkTables(const LoadOptions &options)
+{
+    // NT4 time sync: [-1, 0, int type, client time], answered with [-1, server time, int type, client time]
+    RequestBuilder build = [](uint64_t clientTimeUs, bool malformed, std::mt19937 &generator)
+    {
+        std::vector<uint8_t> request = {0x94, 0xff, 0x00, 0x02};
+        if (!malformed)
+        {
+            put_uint64(request, clientTimeUs);
+            return request;
+        }
+
+        if (generator() % 2 == 0)
+            request.resize(2); // array shorter than announced
+        else
+            request = random_bytes(generator, 1 + generator() % MAX_MALFORMED_LENGTH);
+        return request;
+    };
+
+    ResponseParser parse = [](const std::vector<uint8_t> &message, uint64_t &clientTimeUs)
+    {
+        size_t offset = 1;
+        uint64_t topic, serverTime, type;
+        return message.size() > 2 && message[0] == 0x94 && read_uint(message, offset, topic) && topic == (uint64_t)-1 &&
+               read_uint(message, offset, serverTime) && read_uint(message, offset, type) && read_uint(message, offset, clientTimeUs);
+    };
+
+    return run_websocket(options, "networktables", options.ntPort, "/nt/loadgen", "v4.1.networktables.first.wpi.edu, networktables.first.wpi.edu", build, parse);
+}
+
+static void xbox_client(const LoadOptions &options, int index, LoadReport &result)
+{
+    std::mt19937 generator(std::random_device{}() + index);
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.xboxPort);
+    hostent *host = gethostbyname(options.host.c_str());
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (host == nullptr || fd < 0)
+    {
+        result.errors++;
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+    memcpy(&address.sin_addr, host->h_addr_list[0], sizeof(address.sin_addr));
+    result.connected = 1;
+
+    std::vector<uint8_t> neutral(options.xboxSize, 0);
+    uint64_t periodUs = (uint64_t)(1000000.0 / options.rate);
+    uint64_t endUs = now_us() + (uint64_t)(options.duration * 1000000.0);
+    uint64_t nextUs = now_us() + periodUs * index / options.clients;
+
+    while (now_us() < endUs)
+    {
+        std::this_thread::sleep_until(Clock::time_point(std::chrono::microseconds(nextUs)));
+        nextUs += periodUs;
+
+        bool malformed = (int)(generator() % 100) < options.malformedPercent;
+        std::vector<uint8_t> datagram = malformed ? random_bytes(generator, generator() % (MAX_MALFORMED_LENGTH + 1)) : neutral;
+        if (sendto(fd, datagram.data(), datagram.size(), 0, (sockaddr *)&address, sizeof(address)) != (ssize_t)datagram.size())
+        {
+            result.errors++;
+            continue;
+        }
+        result.sent++;
+        result.bytesSent += datagram.size();
+        if (malformed)
+            result.malformed++;
+    }
+
+    close(fd);
+}
+
+LoadReport runXbox(const LoadOptions &options)
+{
+    std::vector<LoadReport> results(options.clients, LoadReport{});
+    std::vector<std::thread> threads;
+
+    uint64_t startUs = now_us();
+    for (int i = 0; i < options.clients; i++)
+        threads.emplace_back(xbox_client, std::cref(options), i, std::ref(results[i]));
+    for (std::thread &thread : threads)
+        thread.join();
+
+    LoadReport report = {};
+    report.name = "xbox";
+    report.clients = options.clients;
+    report.seconds = (now_us() - startUs) / 1e6;
+    for (const LoadReport &result : results)
+        merge(report, result);
+    return report;
+}
@@ -0,0 +1,279 @@
+// Standard headers
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+// System headers
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "websocket.h"
+
+static constexpr int FRAME_REST_TIMEOUT_MS = 1000; // rest of a frame once its header arrived
+static constexpr size_t MAX_RESPONSE_HEADER = 4096;
+static constexpr size_t MAX_PAYLOAD = 1 << 20;
+
+static std::string base64(const uint8_t *data, size_t length)
+{
+    static const char *ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string out;
+    for (size_t i = 0; i < length; i += 3)
+    {
+        uint32_t chunk = (uint32_t)data[i] << 16;
+        if (i + 1 < length)
+            chunk |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length)
+            chunk |= data[i + 2];
+
+        out += ALPHABET[(chunk >> 18) & 0x3F];
+        out += ALPHABET[(chunk >> 12) & 0x3F];
+        out += i + 1 < length ? ALPHABET[(chunk >> 6) & 0x3F] : '=';
+        out += i + 2 < length ? ALPHABET[chunk & 0x3F] : '=';
+    }
+    return out;
+}
+
+static uint32_t random_word()
+{
+    thread_local std::mt19937 generator(std::random_device{}());
+    return generator();
+}
+
+WsClient::WsClient() : fd(-1), bytesSent(0), bytesReceived(0)
+{
+}
+
+WsClient::~WsClient()
+{
+    close();
+}
+
+bool WsClient::connect(const std::string &host, int port, const std::string &path, const std::string &protocol, int timeoutMs)
+{
+    close();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
+        return false;
+
+    fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    bool connected = fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) == 0;
+    freeaddrinfo(result);
+    if (!connected)
+    {
+        close();
+        return false;
+    }
+
+    // small frames, latency matters more than packing
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    uint8_t key[16];
+    for (size_t i = 0; i < sizeof(key); i++)
+        key[i] = (uint8_t)random_word();
+
+    std::string request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + host + ":" + std::to_string(port) + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + base64(key, sizeof(key)) + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n";
+    if (!protocol.empty())
+        request += "Sec-WebSocket-Protocol: " + protocol + "\r\n";
+    request += "\r\n";
+
+    if (!writeAll((const uint8_t *)request.data(), request.size()))
+    {
+        close();
+        return false;
+    }
+
+    // byte at a time so no frame data is read past the header
+    std::string response;
+    while (response.size() < MAX_RESPONSE_HEADER && response.find("\r\n\r\n") == std::string::npos)
+    {
+        uint8_t c;
+        if (!readExact(&c, 1, timeoutMs))
+        {
+            close();
+            return false;
+        }
+        response += (char)c;
+    }
+
+    if (response.compare(0, 12, "HTTP/1.1 101") != 0)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void WsClient::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+bool WsClient::send(WsOpcode opcode, const uint8_t *data, size_t length)
+{
+    if (fd < 0)
+        return false;
+
+    std::vector<uint8_t> frame;
+    frame.reserve(length + 14);
+    frame.push_back(0x80 | (uint8_t)opcode);
+
+    // client frames are always masked
+    if (length < 126)
+    {
+        frame.push_back(0x80 | (uint8_t)length);
+    }
+    else if (length <= 0xFFFF)
+    {
+        frame.push_back(0x80 | 126);
+        frame.push_back((uint8_t)(length >> 8));
+        frame.push_back((uint8_t)length);
+    }
+    else
+    {
+        frame.push_back(0x80 | 127);
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame.push_back((uint8_t)((uint64_t)length >> shift));
+    }
+
+    uint32_t maskWord = random_word();
+    uint8_t mask[4] = {(uint8_t)(maskWord >> 24), (uint8_t)(maskWord >> 16), (uint8_t)(maskWord >> 8), (uint8_t)maskWord};
+    frame.insert(frame.end(), mask, mask + 4);
+    for (size_t i = 0; i < length; i++)
+        frame.push_back(data[i] ^ mask[i & 3]);
+
+    if (!writeAll(frame.data(), frame.size()))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool WsClient::receive(WsMessage &out, int timeoutMs)
+{
+    while (fd >= 0)
+    {
+        uint8_t header[2];
+        if (!readExact(header, 1, timeoutMs))
+            return false;
+        if (!readExact(&header[1], 1, FRAME_REST_TIMEOUT_MS))
+        {
+            close();
+            return false;
+        }
+
+        WsOpcode opcode = (WsOpcode)(header[0] & 0x0F);
+        bool masked = (header[1] & 0x80) != 0;
+        uint64_t length = header[1] & 0x7F;
+
+        uint8_t extended[8];
+        if (length == 126)
+        {
+            if (!readExact(extended, 2, FRAME_REST_TIMEOUT_MS))
+            {
+                close();
+                return false;
+            }
+            length = ((uint64_t)extended[0] << 8) | extended[1];
+        }
+        else if (length == 127)
+        {
+            if (!readExact(extended, 8, FRAME_REST_TIMEOUT_MS))
+            {
+                close();
+                return false;
+            }
+            length = 0;
+            for (int i = 0; i < 8; i++)
+                length = (length << 8) | extended[i];
+        }
+
+        uint8_t mask[4] = {};
+        if (length > MAX_PAYLOAD || (masked && !readExact(mask, 4, FRAME_REST_TIMEOUT_MS)))
+        {
+            close();
+            return false;
+        }
+
+        std::vector<uint8_t> payload(length);
+        if (length > 0 && !readExact(payload.data(), length, FRAME_REST_TIMEOUT_MS))
+        {
+            close();
+            return false;
+        }
+        if (masked)
+            for (size_t i = 0; i < payload.size(); i++)
+                payload[i] ^= mask[i & 3];
+
+        switch (opcode)
+        {
+        case WsOpcode::Ping:
+            // the driver station drops clients that miss a pong
+            send(WsOpcode::Pong, payload.data(), payload.size());
+            break;
+        case WsOpcode::Close:
+            close();
+            return false;
+        case WsOpcode::Text:
+        case WsOpcode::Binary:
+            out.opcode = opcode;
+            out.payload = std::move(payload);
+            return true;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+bool WsClient::readExact(uint8_t *data, size_t length, int timeoutMs)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) <= 0)
+            return false;
+
+        ssize_t n = recv(fd, data + done, length - done, 0);
+        if (n <= 0)
+        {
+            close();
+            return false;
+        }
+        done += n;
+        bytesReceived += n;
+    }
+    return true;
+}
+
+bool WsClient::writeAll(const uint8_t *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = ::send(fd, data + done, length - done, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        done += n;
+        bytesSent += n;
+    }
+    return true;
+}